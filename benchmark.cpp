@@ -0,0 +1,193 @@
+// benchmark.cpp: parsing throughput of checkerlib against stdio baselines
+//
+// usage: ./benchmark [max_tokens]
+//
+// For each input shape and size, a test file is generated and then read
+// back in several ways.  The Reader rows are complete validations: every
+// token is read with its delimiter checked, followed by readEof().
+#include "checkerlib.h"
+#include <ctime>
+using namespace checker;
+
+struct Shape {
+  const char *name;
+  int per_line;        // tokens per line (0: all on one line)
+  long long min_val, max_val;
+  int negative_pct;    // share of negated values, in percent
+};
+
+const Shape shapes[] = {
+  { "small ints",       1, 0, 99, 0 },
+  { "full-range longs", 2, LLONG_MIN, LLONG_MAX, 50 },
+  { "negative-heavy",   2, -1000000000, 1000000000, 90 },
+  { "long lines",       0, -1000000000, 1000000000, 50 },
+  { "short lines",      1, 0, 9, 0 },
+};
+
+unsigned long long xorshift64() {
+  static unsigned long long x = 88172645463325252ULL;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return x;
+}
+
+long long randomValue(const Shape& shape) {
+  unsigned long long span = (unsigned long long)shape.max_val - shape.min_val;
+  unsigned long long r = xorshift64();
+  long long val = span == ~0ULL ? (long long)r : shape.min_val + (long long)(r % (span + 1));
+  bool negate = (int)(xorshift64() % 100) < shape.negative_pct;
+  if(val > 0 && negate) val = -val;
+  if(val < 0 && !negate && val != LLONG_MIN) val = -val;
+  if(val > shape.max_val) val = shape.max_val;
+  if(val < shape.min_val) val = shape.min_val;
+  return val;
+}
+
+bool isLastInLine(const Shape& shape, int i, int n) {
+  return i+1 == n || (shape.per_line && i % shape.per_line == shape.per_line-1);
+}
+
+std::string generate(const Shape& shape, int n) {
+  char path[] = "/tmp/checkerlib-bench-XXXXXX";
+  int fd = mkstemp(path);
+  if(fd < 0) throw std::runtime_error(std::string("mkstemp: ")+strerror(errno));
+  FILE *fp = fdopen(fd, "w");
+  fprintf(fp, "%d\n", n);
+  for(int i = 0; i < n; i++) {
+    fprintf(fp, "%lld%c", randomValue(shape), isLastInLine(shape, i, n) ? '\n' : ' ');
+  }
+  fclose(fp);
+  return path;
+}
+
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+template<typename T>
+T readToken(Reader& in, const Shape& shape, int i, int n);
+template<>
+int readToken<int>(Reader& in, const Shape& shape, int i, int n) {
+  Reader::IntData d = in.readInt("x[%d]", i);
+  return isLastInLine(shape, i, n) ? d.eol() : d.spc();
+}
+template<>
+long long readToken<long long>(Reader& in, const Shape& shape, int i, int n) {
+  Reader::LongData d = in.readLong("x[%d]", i);
+  return isLastInLine(shape, i, n) ? d.eol() : d.spc();
+}
+
+template<typename T>
+long long readAll(Reader& in, const Shape& shape) {
+  const int n = in.readInt("n").eol();
+  long long sum = 0;
+  for(int i = 0; i < n; i++) {
+    sum += readToken<T>(in, shape, i, n);
+  }
+  in.readEof();
+  return sum;
+}
+
+template<typename T>
+long long runReader(const Shape& shape, const std::string& path) {
+  Reader in(path.c_str());
+  return readAll<T>(in, shape);
+}
+
+long long runReaderDump(const Shape& shape, const std::string& path) {
+  fflush(stderr);
+  int saved = dup(2);
+  int devnull = open("/dev/null", O_WRONLY);
+  dup2(devnull, 2);
+  close(devnull);
+  long long sum;
+  {
+    Reader in(path.c_str());
+    in.enableIODump();
+    sum = readAll<long long>(in, shape);
+  }
+  fflush(stderr);
+  dup2(saved, 2);
+  close(saved);
+  return sum;
+}
+
+long long runReaderPipe(const Shape& shape, const std::string& path) {
+  Process p;
+  p.push("cat").push(path.c_str()).execute();
+  long long sum = readAll<long long>(p, shape);
+  p.closeProcess();
+  return sum;
+}
+
+long long runScanf(const Shape&, const std::string& path) {
+  FILE *fp = fopen(path.c_str(), "r");
+  int n;
+  long long sum = 0, val;
+  if(fscanf(fp, "%d", &n) != 1) n = 0;
+  for(int i = 0; i < n && fscanf(fp, "%lld", &val) == 1; i++) {
+    sum += val;
+  }
+  fclose(fp);
+  return sum;
+}
+
+long long runStrtoll(const Shape&, const std::string& path) {
+  FILE *fp = fopen(path.c_str(), "r");
+  std::string data;
+  char chunk[1 << 16];
+  size_t len;
+  while((len = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+    data.append(chunk, len);
+  }
+  fclose(fp);
+  const char *p = data.c_str();
+  char *next;
+  int n = strtol(p, &next, 10);
+  long long sum = 0;
+  for(int i = 0; i < n; i++) {
+    p = next;
+    sum += strtoll(p, &next, 10);
+  }
+  return sum;
+}
+
+typedef long long (*Runner)(const Shape&, const std::string&);
+
+void measure(const char *method, Runner run, const Shape& shape, const std::string& path, int n, long long bytes) {
+  double best = 1e100;
+  for(int rep = 0; rep < 3; rep++) {
+    double start = now();
+    volatile long long sum = run(shape, path);
+    (void)sum;
+    best = std::min(best, now() - start);
+  }
+  printf("  %-18s %10.1f MB/s %10.2f Mtokens/s\n", method, bytes / best / 1e6, n / best / 1e6);
+  fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+  const int max_tokens = argc > 1 ? atoi(argv[1]) : 2000000;
+  for(size_t s = 0; s < sizeof(shapes)/sizeof(shapes[0]); s++) {
+    const Shape& shape = shapes[s];
+    for(int n = 20000; n <= max_tokens; n *= 10) {
+      std::string path = generate(shape, n);
+      struct stat st;
+      stat(path.c_str(), &st);
+      printf("%s, %d tokens, %.1f MB\n", shape.name, n, st.st_size / 1e6);
+      if(shape.max_val <= INT_MAX && shape.min_val >= INT_MIN) {
+        measure("readInt", runReader<int>, shape, path, n, st.st_size);
+      }
+      measure("readLong", runReader<long long>, shape, path, n, st.st_size);
+      measure("readLong (pipe)", runReaderPipe, shape, path, n, st.st_size);
+      measure("readLong (IODump)", runReaderDump, shape, path, n, st.st_size);
+      measure("scanf", runScanf, shape, path, n, st.st_size);
+      measure("strtoll", runStrtoll, shape, path, n, st.st_size);
+      unlink(path.c_str());
+    }
+  }
+  return 0;
+}
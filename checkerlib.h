@@ -18,10 +18,13 @@
 
 #include <cerrno>
 #include <climits>
+#include <cmath>
 #include <cstdarg>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <cwchar>
 
 ////
 //// platform-independence
@@ -55,9 +58,31 @@ inline void DisplayError(const char *pszAPI)
   ExitProcess(GetLastError());
 }
 #else
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <dirent.h>
+#endif
+
+// Compressed input files are recognized if the libraries are available
+// (define these and link with -lz / -lzstd); POSIX only.
+#if !defined(_WIN32) || defined(__unix__)
+#ifdef CHECKERLIB_HAVE_ZLIB
+#include <zlib.h>
+#define CHECKERLIB_DECOMPRESS
+#endif
+#ifdef CHECKERLIB_HAVE_ZSTD
+#include <zstd.h>
+#define CHECKERLIB_DECOMPRESS
+#endif
 #endif
 
 ////
@@ -80,11 +105,60 @@ inline void DisplayError(const char *pszAPI)
 
 #endif
 
+#if defined(va_copy)
+#define CHECKERLIB_VA_COPY(dst,src) va_copy(dst,src)
+#elif defined(__va_copy)
+#define CHECKERLIB_VA_COPY(dst,src) __va_copy(dst,src)
+#else
+#define CHECKERLIB_VA_COPY(dst,src) memcpy(&(dst), &(src), sizeof(va_list))
+#endif
+
+// Exact double arithmetic: every operation rounds to double precision
+// (no x87 excess precision, no reciprocal tricks), as readDouble's fast
+// path requires.
+#if ((defined(__FLT_EVAL_METHOD__) && __FLT_EVAL_METHOD__ == 0) || \
+    defined(_M_X64) || defined(_M_ARM64)) && !defined(__FAST_MATH__)
+#define CHECKERLIB_EXACT_DOUBLE
+#endif
+
+// Performance counters are kept only if CHECKERLIB_COUNTERS is defined
+// before this header is included; otherwise their hooks vanish.
+#ifdef CHECKERLIB_COUNTERS
+#define CHECKERLIB_COUNT(stmt) stmt
+#else
+#define CHECKERLIB_COUNT(stmt)
+#endif
+
+// The input schemas (checker::schema) need C++11; the rest of the header
+// stays C++03.
+#if __cplusplus >= 201103L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201103L)
+#define CHECKERLIB_CXX11
+#endif
+// std::uncaught_exception() is deprecated in C++17 and gone in C++20.
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define CHECKERLIB_CXX17
+#endif
+// ~Reader and ~Process report misuse and verdicts by throwing, which
+// C++11 destructors may only do when declared so.
+#ifdef CHECKERLIB_CXX11
+#define CHECKERLIB_THROWING_DTOR noexcept(false)
+#else
+#define CHECKERLIB_THROWING_DTOR
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHECKERLIB_X86_SIMD
+#include <immintrin.h>
+#endif
+
 #include <algorithm>
 #include <exception>
 #include <stdexcept>
 #include <vector>
 #include <string>
+#ifdef CHECKERLIB_CXX11
+#include <array>
+#endif
 
 namespace checker {
   // integer constants for parsing
@@ -97,52 +171,480 @@ namespace checker {
   const long long LLONG_MIN_DECIMAL_U = -922337203685477580LL;
   const int LLONG_MIN_DECIMAL_L = -8;
 
+  namespace detail {
+    // strerror is not thread-safe; either flavour of strerror_r is.
+    inline const char *strerrorResult(int ret, const char *buf) {
+      return ret == 0 ? buf : "Unknown error";
+    }
+    inline const char *strerrorResult(const char *ret, const char *) {
+      return ret;
+    }
+    inline std::string errorString(int errnum) {
+      char buf[256];
+      buf[0] = '\0';
+#if defined(_WIN32) && !defined(__unix__)
+      strerror_s(buf, sizeof(buf), errnum);
+      return buf;
+#else
+      return strerrorResult(strerror_r(errnum, buf, sizeof(buf)), buf);
+#endif
+    }
+
+    // Writes the decimal digits of v backwards, two at a time, ending
+    // just before end; returns the first digit.
+    template<typename U>
+    inline char *formatDigits(char *end, U v) {
+      static const char pairs[] =
+        "00010203040506070809" "10111213141516171819"
+        "20212223242526272829" "30313233343536373839"
+        "40414243444546474849" "50515253545556575859"
+        "60616263646566676869" "70717273747576777879"
+        "80818283848586878889" "90919293949596979899";
+      char *p = end;
+      while(v >= 100) {
+        const char *d = pairs + (v % 100) * 2;
+        v /= 100;
+        *--p = d[1];
+        *--p = d[0];
+      }
+      if(v >= 10) {
+        *--p = pairs[v * 2 + 1];
+        *--p = pairs[v * 2];
+      } else {
+        *--p = (char)('0' + v);
+      }
+      return p;
+    }
+    inline char *formatDecimal(char *end, long long v) {
+      if(v >= 0) {
+        return (unsigned long long)v <= UINT_MAX ?
+          formatDigits(end, (unsigned int)v) : formatDigits(end, (unsigned long long)v);
+      }
+      char *p = formatDigits(end, 0ULL - (unsigned long long)v);
+      *--p = '-';
+      return p;
+    }
+  }
+
+  // Buffer sizes for the allocation-free itos/ltos below, including the
+  // terminating NUL.
+  const int ITOS_BUFFER_SIZE = 12;
+  const int LTOS_BUFFER_SIZE = 21;
+
+  // Writes i into buf as a NUL-terminated string and returns buf.
+  inline char *itos(int i, char *buf) {
+    char tmp[ITOS_BUFFER_SIZE];
+    char *p = detail::formatDecimal(tmp + sizeof(tmp), i);
+    memcpy(buf, p, tmp + sizeof(tmp) - p);
+    buf[tmp + sizeof(tmp) - p] = '\0';
+    return buf;
+  }
+
+  inline char *ltos(long long i, char *buf) {
+    char tmp[LTOS_BUFFER_SIZE];
+    char *p = detail::formatDecimal(tmp + sizeof(tmp), i);
+    memcpy(buf, p, tmp + sizeof(tmp) - p);
+    buf[tmp + sizeof(tmp) - p] = '\0';
+    return buf;
+  }
+
   inline std::string itos(int i) {
-    char c_str[12];
-    c_str[11] = '\0';
-    if(i>0) {
-      for(int j = 10; j >= 0; j--) {
-        c_str[j] = '0'+(i%10);
-        i /= 10;
-        if(i == 0) {
-          return std::string(c_str+j);
+    char buf[ITOS_BUFFER_SIZE];
+    return std::string(itos(i, buf));
+  }
+
+  inline std::string ltos(long long i) {
+    char buf[LTOS_BUFFER_SIZE];
+    return std::string(ltos(i, buf));
+  }
+
+  ////
+  //// Parsing kernels
+  ////
+
+  namespace detail {
+    inline size_t digitRunScalar(const char *begin, const char *end) {
+      const char *p = begin;
+      while(p != end && (unsigned char)(*p - '0') < 10) p++;
+      return p - begin;
+    }
+
+    inline unsigned long long load8(const char *p) {
+      unsigned long long chunk;
+      memcpy(&chunk, p, 8);
+      return chunk;
+    }
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    const bool SWAR_LITTLE_ENDIAN = true;
+#else
+    const bool SWAR_LITTLE_ENDIAN = false;
+#endif
+
+    // Portable fallback: tests 8 bytes per step for being all digits.
+    inline size_t digitRunSWAR(const char *begin, const char *end) {
+      const char *p = begin;
+      while(end - p >= 8) {
+        unsigned long long chunk = load8(p);
+        if((chunk & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL ||
+            ((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL) {
+          break;
         }
+        p += 8;
       }
-    } else if(i<0) {
-      for(int j = 10; j >= 0; j--) {
-        if(i == 0) {
-          c_str[j] = '-';
-          return std::string(c_str+j);
+      return (p - begin) + digitRunScalar(p, end);
+    }
+
+#ifdef CHECKERLIB_X86_SIMD
+    __attribute__((target("sse2")))
+    inline size_t digitRunSSE2(const char *begin, const char *end) {
+      const char *p = begin;
+      const __m128i zero = _mm_set1_epi8('0');
+      const __m128i bias = _mm_set1_epi8((char)0x80);
+      const __m128i limit = _mm_set1_epi8((char)(0x80 + 10));
+      while(end - p >= 16) {
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)p), zero);
+        unsigned mask = _mm_movemask_epi8(_mm_cmplt_epi8(_mm_xor_si128(v, bias), limit));
+        if(mask != 0xFFFF) {
+          return (p - begin) + __builtin_ctz(~mask);
         }
-        c_str[j] = '0'-(i%10);
-        i /= 10;
+        p += 16;
       }
+      return (p - begin) + digitRunScalar(p, end);
     }
-    return std::string("0");
-  }
 
-  inline std::string ltos(long long i) {
-    char c_str[21];
-    c_str[20] = '\0';
-    if(i>0) {
-      for(int j = 19; j >= 0; j--) {
-        c_str[j] = '0'+(i%10);
-        i /= 10;
-        if(i == 0) {
-          return std::string(c_str+j);
+    __attribute__((target("avx2")))
+    inline size_t digitRunAVX2(const char *begin, const char *end) {
+      const char *p = begin;
+      const __m256i zero = _mm256_set1_epi8('0');
+      const __m256i nine = _mm256_set1_epi8(9);
+      while(end - p >= 32) {
+        __m256i v = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)p), zero);
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(v, nine), v));
+        if(mask != 0xFFFFFFFFU) {
+          return (p - begin) + __builtin_ctz(~mask);
+        }
+        p += 32;
+      }
+      return (p - begin) + digitRunSSE2(p, end);
+    }
+#endif
+
+    typedef size_t (*DigitRunFunc)(const char *, const char *);
+    inline DigitRunFunc selectDigitRun() {
+#ifdef CHECKERLIB_X86_SIMD
+      __builtin_cpu_init();
+      if(__builtin_cpu_supports("avx2")) return digitRunAVX2;
+      return digitRunSSE2;
+#else
+      return digitRunSWAR;
+#endif
+    }
+
+    // Length of the run of decimal digits starting at begin, using the
+    // widest kernel the running CPU supports.
+    inline size_t digitRun(const char *begin, const char *end) {
+      static const DigitRunFunc func = selectDigitRun();
+      return func(begin, end);
+    }
+
+#ifdef CHECKERLIB_X86_SIMD
+    // Length of the prefix of [begin,end) whose bytes all fall into one
+    // of the n ranges [lo[k], lo[k]+width[k]), 16 bytes at a time; the
+    // last partial block is left to the caller.
+    __attribute__((target("sse2")))
+    inline size_t rangeRunSSE2(const char *begin, const char *end,
+        const unsigned char *lo, const unsigned char *width, int n) {
+      const char *p = begin;
+      const __m128i bias = _mm_set1_epi8((char)0x80);
+      while(end - p >= 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i hit = _mm_setzero_si128();
+        for(int k = 0; k < n; k++) {
+          __m128i d = _mm_xor_si128(_mm_sub_epi8(v, _mm_set1_epi8((char)lo[k])), bias);
+          hit = _mm_or_si128(hit, _mm_cmplt_epi8(d, _mm_set1_epi8((char)(0x80 + width[k]))));
+        }
+        unsigned mask = _mm_movemask_epi8(hit);
+        if(mask != 0xFFFF) {
+          return (p - begin) + __builtin_ctz(~mask);
+        }
+        p += 16;
+      }
+      return p - begin;
+    }
+#endif
+
+    // Converts exactly 8 digits, the first one in the lowest byte.
+    inline unsigned long long convert8(unsigned long long chunk) {
+      chunk = chunk * 10 + (chunk >> 8);
+      return (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+          (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    }
+
+    // Value of the n digits at p (n <= 19).  At least 8 readable bytes
+    // must follow p whenever n is not a multiple of 8 and the SWAR path
+    // is used; otherwise the tail is converted one digit at a time.
+    inline unsigned long long convertDigits(const char *p, size_t n, const char *end) {
+      unsigned long long val = 0;
+      if(SWAR_LITTLE_ENDIAN) {
+        for(; n >= 8; p += 8, n -= 8) {
+          val = val * 100000000ULL + convert8(load8(p) - 0x3030303030303030ULL);
+        }
+        if(n && end - p >= 8) {
+          static const unsigned long long scale[8] = {
+            1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL
+          };
+          unsigned long long chunk = (load8(p) - 0x3030303030303030ULL) << (8 * (8 - n));
+          return val * scale[n] + convert8(chunk);
+        }
+      }
+      for(; n; p++, n--) {
+        val = val * 10 + (*p - '0');
+      }
+      return val;
+    }
+
+    // Parses the integer token at p, advancing p past its digits.  Fails
+    // without moving p if the token has a leading zero (other than a lone
+    // "0"), is "-0", does not fit, or its digits run into end (so it might
+    // continue further).
+    // Overflow is decided from the digit count: anything shorter than
+    // max_digits always fits, and max_digits-long runs are compared once.
+    template<typename T>
+    inline bool parseIntegerAt(const char *&p, const char *end, T& val,
+        unsigned long long max_val, size_t max_digits) {
+      const char *q = p;
+      bool neg = false;
+      if(q != end && *q == '-') {
+        neg = true;
+        q++;
+      }
+      if(q == end) return false;
+      if(*q == '0') {
+        if(neg || q + 1 == end || ('0' <= q[1] && q[1] <= '9')) return false;
+        val = 0;
+        p = q + 1;
+        return true;
+      }
+      if(!('1' <= *q && *q <= '9')) return false;
+      size_t n = digitRun(q, end);
+      if(n > max_digits || q + n == end) return false;
+      unsigned long long u = convertDigits(q, n, end);
+      if(n == max_digits && u > max_val + neg) return false;
+      val = neg ? (T)(0 - u) : (T)u;
+      p = q + n;
+      return true;
+    }
+    inline bool parseIntegerAt(const char *&p, const char *end, int& val) {
+      return parseIntegerAt(p, end, val, INT_MAX, 10);
+    }
+    inline bool parseIntegerAt(const char *&p, const char *end, long long& val) {
+      return parseIntegerAt(p, end, val, LLONG_MAX, 19);
+    }
+
+#ifdef CHECKERLIB_EXACT_DOUBLE
+    // 10^0 .. 10^22 are exactly representable as doubles.
+    inline double exactPow10(int e) {
+      static const double table[23] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+      return table[e];
+    }
+#endif
+
+    // Validates [p,end) as -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    // with at most max_decimals digits after the point (any number if
+    // negative) and converts it to the nearest double.  Returns NULL on
+    // success, or the error message.
+    // Up to 19 significant digits are gathered into an integer m; when
+    // m <= 2^53 and the decimal exponent e satisfies |e| <= 22, both m
+    // and 10^|e| are exact doubles and a single multiplication or
+    // division rounds correctly (Clinger's fast path).  Everything else
+    // goes through strtod.
+    inline const char *parseRealAt(const char *p, const char *end,
+        int max_decimals, bool allow_exponent, double& val) {
+      const char *begin = p;
+      bool neg = false;
+      if(p != end && *p == '-') {
+        neg = true;
+        p++;
+      }
+      const char *int_digits = p;
+      size_t int_len = digitRun(p, end);
+      if(int_len == 0 || (*p == '0' && int_len > 1)) {
+        return "error reading double: not a real number input";
+      }
+      p += int_len;
+      const char *frac_digits = p;
+      size_t frac_len = 0;
+      if(p != end && *p == '.') {
+        frac_digits = ++p;
+        frac_len = digitRun(p, end);
+        if(frac_len == 0) {
+          return "error reading double: not a real number input";
+        }
+        p += frac_len;
+      }
+      if(max_decimals >= 0 && frac_len > (size_t)max_decimals) {
+        return "error reading double: too many digits after the decimal point";
+      }
+      long exponent = 0;
+      if(p != end && (*p == 'e' || *p == 'E')) {
+        if(!allow_exponent) {
+          return "error reading double: exponent is not allowed";
+        }
+        p++;
+        bool exp_neg = false;
+        if(p != end && (*p == '+' || *p == '-')) {
+          exp_neg = *p == '-';
+          p++;
+        }
+        size_t exp_len = digitRun(p, end);
+        if(exp_len == 0) {
+          return "error reading double: not a real number input";
+        }
+        for(; exp_len; p++, exp_len--) {
+          if(exponent < 100000) exponent = exponent * 10 + (*p - '0');
         }
+        if(exp_neg) exponent = -exponent;
       }
-    } else if(i<0) {
-      for(int j = 19; j >= 0; j--) {
-        if(i == 0) {
-          c_str[j] = '-';
-          return std::string(c_str+j);
+      if(p != end) {
+        return "error reading double: not a real number input";
+      }
+
+#ifdef CHECKERLIB_EXACT_DOUBLE
+      // Leading zeros and trailing zeros after the point are not
+      // significant.
+      const char *point = frac_digits;
+      const char *frac_end = frac_digits + frac_len;
+      if(*int_digits == '0') {
+        int_len = 0;
+        while(frac_digits != frac_end && *frac_digits == '0') frac_digits++;
+      }
+      while(frac_end != frac_digits && frac_end[-1] == '0') frac_end--;
+      const size_t sig_frac = frac_end - frac_digits;
+      if(int_len + sig_frac == 0) {
+        val = neg ? -0.0 : 0.0;
+        return NULL;
+      }
+      const long e = exponent - (long)(frac_end - point);
+      if(int_len + sig_frac <= 19 && -22 <= e && e <= 22) {
+        static const unsigned long long scale[20] = {
+          1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+          10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+          100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+          100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+          100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+        };
+        const unsigned long long m = convertDigits(int_digits, int_len, end) * scale[sig_frac] +
+          convertDigits(frac_digits, sig_frac, end);
+        if(m <= (1ULL << 53)) {
+          double x = (double)m;
+          x = e < 0 ? x / exactPow10(-e) : x * exactPow10(e);
+          val = neg ? -x : x;
+          return NULL;
         }
-        c_str[j] = '0'-(i%10);
-        i /= 10;
       }
+#endif
+
+      char small[64];
+      std::string large;
+      const size_t len = end - begin;
+      const char *text = small;
+      if(len >= sizeof(small)) {
+        large.assign(begin, end);
+        text = large.c_str();
+      } else {
+        memcpy(small, begin, len);
+        small[len] = '\0';
+      }
+      val = strtod(text, NULL);
+      if(val == HUGE_VAL || val == -HUGE_VAL) {
+        return "error reading double: Too large real constant";
+      }
+      return NULL;
+    }
+
+    inline int onlineProcessors() {
+#if defined(_WIN32) && !defined(__unix__)
+      return 1;
+#else
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      return n > 0 ? (int)n : 1;
+#endif
+    }
+
+    // Runs func(&tasks[i]) for every task, each on its own thread except
+    // tasks[0], which runs on the calling thread, and waits for all of
+    // them.  Tasks whose thread cannot be created run inline instead.
+    template<typename Task>
+    inline void runParallel(Task *tasks, int n, void *(*func)(void *)) {
+#if defined(_WIN32) && !defined(__unix__)
+      for(int i = 0; i < n; i++) func(&tasks[i]);
+#else
+      std::vector<pthread_t> threads(n);
+      std::vector<bool> started(n, false);
+      for(int i = 1; i < n; i++) {
+        started[i] = pthread_create(&threads[i], NULL, func, &tasks[i]) == 0;
+        if(!started[i]) func(&tasks[i]);
+      }
+      if(n > 0) func(&tasks[0]);
+      for(int i = 1; i < n; i++) {
+        if(started[i]) pthread_join(threads[i], NULL);
+      }
+#endif
     }
-    return std::string("0");
+
+    // One newline-aligned slice of the input for parallel bulk reading.
+    // Phase one counts its lines; phase two parses count records (one
+    // per line, with one or two fields) into xs/ys starting at first,
+    // stopping at the first record the fast path cannot take.
+    template<typename T>
+    struct RecordChunk {
+      const char *begin, *end;
+      int lines;
+      int first, count, parsed;
+      const char *stop;
+      T *xs, *ys;
+      T min_val, max_val;
+
+      static void *countLines(void *arg) {
+        RecordChunk *chunk = (RecordChunk *)arg;
+        int lines = 0;
+        for(const char *p = chunk->begin; (p = (const char *)memchr(p, '\n', chunk->end - p)); p++) {
+          lines++;
+        }
+        chunk->lines = lines;
+        return NULL;
+      }
+      static void *parseRecords(void *arg) {
+        RecordChunk *chunk = (RecordChunk *)arg;
+        const char *p = chunk->begin, *end = chunk->end;
+        T min_val = chunk->min_val, max_val = chunk->max_val;
+        T *xs = chunk->xs + chunk->first;
+        T *ys = chunk->ys ? chunk->ys + chunk->first : NULL;
+        int k;
+        const char *record = p;
+        for(k = 0; k < chunk->count; k++) {
+          T x, y;
+          record = p;
+          if(!parseIntegerAt(p, end, x) || !(min_val <= x && x <= max_val)) break;
+          if(ys) {
+            if(*p != ' ') break;
+            p++;
+            if(!parseIntegerAt(p, end, y) || !(min_val <= y && y <= max_val)) break;
+          }
+          if(*p != '\n') break;
+          p++;
+          xs[k] = x;
+          if(ys) ys[k] = y;
+        }
+        chunk->parsed = k;
+        chunk->stop = k < chunk->count ? record : p;
+        return NULL;
+      }
+    };
   }
 
   // exception
@@ -156,6 +658,22 @@ namespace checker {
     ProcessError(const std::string& what) : std::runtime_error(what) {}
   };
 
+  // Verdicts raised by Process::closeProcess().
+  class TimeLimitExceeded : public ProcessError {
+  public:
+    TimeLimitExceeded(const std::string& what) : ProcessError(what) {}
+  };
+
+  class MemoryLimitExceeded : public ProcessError {
+  public:
+    MemoryLimitExceeded(const std::string& what) : ProcessError(what) {}
+  };
+
+  class RuntimeError : public ProcessError {
+  public:
+    RuntimeError(const std::string& what) : ProcessError(what) {}
+  };
+
   class Uncopyable {
   protected:
       Uncopyable() {}
@@ -165,188 +683,1136 @@ namespace checker {
       Uncopyable& operator=(const Uncopyable&);
   };
 
-  class Reader : private Uncopyable {
-    friend class TokenData;
-    friend class Process;
-    FILE *internal_fp;
-    char *filename;
-    int lastchar;
-    int line,col;
-    char *varname;
-    std::string *linecache;
-    void init() {
-      internal_fp = NULL;
-      filename = NULL;
-      lastchar = -1;
-      line = -1;
-      col = 0;
-      varname = new char[1000];
-      linecache = NULL;
-    }
-    void open(FILE *fp, const char *filename) {
-      if(internal_fp) throw std::domain_error("Reader::open(FILE*,const char*): already opened.");
-      if(!fp) throw std::invalid_argument("Reader::open(FILE*,const char*): fp is NULL.");
-      if(!filename) throw std::invalid_argument("Reader::open(FILE*,const char*): filename is NULL.");
+  // Characters owned by someone else.  The views returned by Reader stay
+  // valid until the next read from the same Reader.
+  class StringView {
+    const char *ptr;
+    size_t len;
+  public:
+    StringView() : ptr(""), len(0) {}
+    StringView(const char *ptr, size_t len) : ptr(ptr), len(len) {}
+    StringView(const char *str) : ptr(str), len(strlen(str)) {}
+    StringView(const std::string& str) : ptr(str.data()), len(str.size()) {}
+    const char *data() const { return ptr; }
+    size_t size() const { return len; }
+    size_t length() const { return len; }
+    bool empty() const { return len == 0; }
+    const char *begin() const { return ptr; }
+    const char *end() const { return ptr + len; }
+    char operator[](size_t i) const { return ptr[i]; }
+    std::string str() const { return std::string(ptr, len); }
+  };
+  inline bool operator==(const StringView& a, const StringView& b) {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size()) == 0;
+  }
+  inline bool operator!=(const StringView& a, const StringView& b) {
+    return !(a == b);
+  }
 
-      this->internal_fp = fp;
-      int filename_len = std::min<int>(1000,strlen(filename)+1);
-      this->filename = new char[filename_len];
-      strncpy(this->filename, filename, filename_len);
-      strcpy(varname, "<init>");
-    }
-    int readChar() {
-      int ret = fgetc(internal_fp);
-      if(ferror(internal_fp)) {
-        throw std::runtime_error(std::string("error reading file: ")+strerror(errno));
-      }
-#if defined(_WIN32) && !defined(__unix__)
-      if(ret=='\r') {
-        ret = fgetc(internal_fp);
-        if(ferror(internal_fp)) {
-          throw std::runtime_error(std::string("error reading file: ")+strerror(errno));
+  // A set of bytes for validating strings, written like the inside of a
+  // regex bracket expression: "a-zA-Z0-9_".  A '-' that is not between
+  // two characters stands for itself.
+  class Charset {
+    bool member[256];
+    // The set as maximal runs of bytes, for the SIMD scan; num_ranges is
+    // -1 when there are too many runs (or one covering every byte).
+    int num_ranges;
+    unsigned char range_lo[4], range_width[4];
+    void update() {
+      num_ranges = 0;
+      for(int c = 0; c < 256; ) {
+        if(!member[c]) {
+          c++;
+          continue;
         }
-      }
-#endif
-      if(linecache) {
-        if(ret=='\n') {
-          fprintf(stderr, "%s<in>: %2d: %s\n", filename, line, linecache->c_str());
-          linecache->clear();
+        int lo = c;
+        while(c < 256 && member[c]) c++;
+        if(num_ranges < 0 || num_ranges == 4 || c - lo == 256) {
+          num_ranges = -1;
         } else {
-          linecache->push_back(ret);
+          range_lo[num_ranges] = (unsigned char)lo;
+          range_width[num_ranges] = (unsigned char)(c - lo);
+          num_ranges++;
         }
       }
-      if(lastchar=='\n') {
-        line++;
-        col=1;
-      } else {
-        col++;
-      }
-      lastchar = ret;
-      return ret;
     }
   public:
-    Reader() {
-      init();
+    Charset() {
+      std::fill(member, member + 256, false);
+      num_ranges = 0;
     }
-    void open(const char *filename) {
-      FILE *fp = fopen(filename, "r");
-      if(fp) {
-        open(fp, filename);
-      } else {
-        throw std::runtime_error(std::string("Reader::open(const char*): error opening file: ")+strerror(errno));
+    explicit Charset(const char *spec) {
+      std::fill(member, member + 256, false);
+      for(const unsigned char *s = (const unsigned char *)spec; *s; s++) {
+        if(s[1] == '-' && s[2] && s[0] <= s[2]) {
+          std::fill(member + s[0], member + s[2] + 1, true);
+          s += 2;
+        } else {
+          member[*s] = true;
+        }
       }
+      update();
     }
-    Reader(FILE *fp) {
-      if(fp==stdin) {
-        init();
-        open(stdin, "<stdin>");
-      } else {
-        throw std::invalid_argument("Reader(FILE*): fp must be stdin.");
-      }
+    // Adds the bytes lo..hi.
+    Charset& add(int lo, int hi) {
+      for(int c = std::max(lo, 0); c <= std::min(hi, 255); c++) member[c] = true;
+      update();
+      return *this;
     }
-    Reader(const char *filename) {
-      FILE *fp = fopen(filename, "r");
-      if(fp) {
-        init();
-        open(fp, filename);
-      } else {
-        throw std::runtime_error(std::string("Reader(const char*): error opening file: ")+strerror(errno));
-      }
+    bool contains(int c) const {
+      return 0 <= c && c < 256 && member[c];
     }
-    void dispose() {
-      if(internal_fp) {
-        throw std::logic_error(std::string(filename)+": call readEof() or abortReading() before disposing!");
+    // Length of the prefix of [begin,end) made of members.
+    size_t span(const char *begin, const char *end) const {
+      const char *p = begin;
+#ifdef CHECKERLIB_X86_SIMD
+      if(num_ranges > 0) {
+        p += detail::rangeRunSSE2(p, end, range_lo, range_width, num_ranges);
       }
+#endif
+      while(p != end && member[(unsigned char)*p]) p++;
+      return p - begin;
     }
-    ~Reader() {
-      dispose();
-      if(linecache) delete linecache;
-      delete[] varname;
-    }
-    std::string positionDescription() {
-      return std::string(filename)+"("+itos(line)+","+itos(col)+","+varname+"): ";
-    }
-    void abortReading() {
-      internal_fp = NULL;
-    }
-    void abortReadingWithError(const std::string& str) ATTR_NORETURN {
-      abortReading();
-      throw ParseError(positionDescription()+str);
-    }
+  };
 
-    template<typename T>
-    class DelimiterData {
-      friend class Reader;
-    protected:
-      Reader& reader;
-      int delim;
-      T data;
-      DelimiterData(Reader& reader, int delim, T data)
-        : reader(reader), delim(delim), data(data) {}
+  namespace detail {
+    // Collects the IODump traffic of every reader and process, in program
+    // order, in one ring buffer.  Producers only copy bytes; splitting
+    // them into numbered "<in>"/"<out>" lines and writing them out is
+    // left to a background thread.
+    class DumpLog : private Uncopyable {
     public:
-      int getDelim() const { return this->delim; }
-      T getData() const { return this->data; }
-      T eol() const {
-        if(delim!='\n') {
-          reader.abortReadingWithError("delimiter EOL is expected");
-        }
-        return data;
+      enum { STREAM_IN, STREAM_OUT };
+    private:
+      enum { REC_OPEN, REC_NAME, REC_LINE, REC_DATA, REC_EOF, REC_CLOSE };
+      struct Record {
+        int type, stream, kind, line, last, len;
+      };
+      struct Stream {
+        std::string name, pending;
+        int kind, line, last;
+      };
+      static const size_t RING_SIZE = 1 << 20;
+      static const size_t MAX_CHUNK = RING_SIZE / 4;
+      std::vector<char> ring;
+      // total bytes ever written, taken by the drainer, and written out
+      unsigned long long head, tail, drained;
+      int next_stream;
+      // touched only by the drainer (or under the lock without a thread)
+      std::vector<Stream *> streams;
+      std::string out;
+      FILE *sink;
+      bool owns_sink;
+      bool threaded;
+      // the drainer is processing a batch outside the lock, using sink
+      bool writing;
+#if !defined(_WIN32) || defined(__unix__)
+      pthread_mutex_t mutex;
+      pthread_cond_t cond;
+      pthread_t thread;
+      void lock() { pthread_mutex_lock(&mutex); }
+      void unlock() { pthread_mutex_unlock(&mutex); }
+      void wait() { pthread_cond_wait(&cond, &mutex); }
+      void notify() { pthread_cond_broadcast(&cond); }
+#else
+      void lock() {}
+      void unlock() {}
+      void wait() {}
+      void notify() {}
+#endif
+      DumpLog() : ring(RING_SIZE), head(0), tail(0), drained(0), next_stream(0),
+          sink(stderr), owns_sink(false), threaded(false), writing(false) {
+#if !defined(_WIN32) || defined(__unix__)
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&cond, NULL);
+        threaded = pthread_create(&thread, NULL, drainMain, this) == 0;
+#endif
       }
-      T spc() const {
-        if(delim!=' ') {
-          reader.abortReadingWithError("delimiter SPC is expected");
+      static void flushAtExit() {
+        instance().flush();
+      }
+      static void *drainMain(void *arg) {
+        static_cast<DumpLog *>(arg)->drainLoop();
+        return NULL;
+      }
+      void drainLoop() {
+        std::vector<char> local;
+        lock();
+        for(;;) {
+          while(head == tail) wait();
+          const size_t n = head - tail;
+          local.resize(n);
+          copyOut(&local[0], n);
+          writing = true;
+          notify();
+          unlock();
+          process(&local[0], n);
+          lock();
+          writing = false;
+          drained += n;
+          notify();
         }
-        return data;
       }
-      T ary(int i, int n) const {
-        if(i<0 || i >=n) {
-          throw std::invalid_argument("DelimiterData::ary(int,int): invalid condition");
+      void copyIn(const void *data, size_t len) {
+        const char *p = (const char *)data;
+        size_t at = head % RING_SIZE;
+        size_t first = std::min(len, RING_SIZE - at);
+        memcpy(&ring[at], p, first);
+        memcpy(&ring[0], p + first, len - first);
+        head += len;
+      }
+      void copyOut(char *dst, size_t len) {
+        size_t at = tail % RING_SIZE;
+        size_t first = std::min(len, RING_SIZE - at);
+        memcpy(dst, &ring[at], first);
+        memcpy(dst + first, &ring[0], len - first);
+        tail += len;
+      }
+      void put(int type, int stream, const char *data, int len, int kind = 0, int line = 0, int last = 0) {
+        Record rec;
+        rec.type = type;
+        rec.stream = stream;
+        rec.kind = kind;
+        rec.line = line;
+        rec.last = last;
+        rec.len = len;
+        const size_t need = sizeof(rec) + len;
+        lock();
+        if(!threaded) {
+          std::vector<char> local(need);
+          memcpy(&local[0], &rec, sizeof(rec));
+          if(len) memcpy(&local[sizeof(rec)], data, len);
+          process(&local[0], need);
+          unlock();
+          return;
         }
-        if(i+1==n) {
-          return this->eol();
-        } else {
-          return this->spc();
+        while(RING_SIZE - (head - tail) < need) {
+          notify();
+          wait();
         }
+        copyIn(&rec, sizeof(rec));
+        if(len) copyIn(data, len);
+        notify();
+        unlock();
       }
-    };
-
-    class IntData : public DelimiterData<int> {
-      friend class Reader;
-      IntData(Reader& reader, int delim, int data)
-        : DelimiterData<int>(reader,delim,data) {}
-    public:
-      IntData range(int min_val, int max_val) const {
-        if(! (min_val <= this->getData() && this->getData() <= max_val) ) {
-          this->reader.abortReadingWithError("invalid range");
+      // the original line rules of IODump: an input line is numbered by
+      // the position of the reader when dumping started, an output line
+      // counts from 1.
+      void emit(Stream& s, const char *tag, int line) {
+        char num[16];
+        snprintf(num, sizeof(num), "%2d", line);
+        out += s.name;
+        out += tag;
+        out += num;
+        out += ": ";
+        out += s.pending.c_str();
+        out += '\n';
+        s.pending.clear();
+      }
+      void process(const char *p, size_t n) {
+        for(const char *end = p + n; p < end; ) {
+          Record rec;
+          memcpy(&rec, p, sizeof(rec));
+          const char *data = p + sizeof(rec);
+          p = data + rec.len;
+          if(rec.type == REC_OPEN) {
+            if((int)streams.size() <= rec.stream) streams.resize(rec.stream + 1, NULL);
+            Stream *s = new Stream();
+            s->name.assign(data, rec.len);
+            s->kind = rec.kind;
+            s->line = rec.line;
+            s->last = rec.last;
+            streams[rec.stream] = s;
+            continue;
+          }
+          Stream& s = *streams[rec.stream];
+          if(rec.type == REC_NAME) {
+            s.name.assign(data, rec.len);
+          } else if(rec.type == REC_LINE) {
+            s.line = rec.line;
+          } else if(rec.type == REC_CLOSE) {
+            delete streams[rec.stream];
+            streams[rec.stream] = NULL;
+          } else if(s.kind == STREAM_OUT) {
+            for(const char *q = data; q < p; q++) {
+              if(*q == '\n') {
+                emit(s, "<out>: ", s.line++);
+              } else {
+                s.pending.push_back(*q);
+              }
+            }
+          } else if(rec.type == REC_EOF) {
+            s.pending.push_back((char)-1);
+            if(s.last == '\n') s.line++;
+            s.last = -1;
+          } else {
+            for(const char *q = data; q < p; q++) {
+              if(*q == '\n') {
+                emit(s, "<in>: ", s.line);
+              } else {
+                s.pending.push_back(*q);
+              }
+              if(s.last == '\n') s.line++;
+              s.last = (unsigned char)*q;
+            }
+          }
+        }
+        if(!out.empty()) {
+          fwrite(out.data(), 1, out.size(), sink);
+          fflush(sink);
+          out.clear();
         }
-        return *this;
+      }
+      // never destroyed, so that readers outliving static destruction can
+      // still log; pending output is written by the atexit hook.
+      static DumpLog *&pointer() {
+        static DumpLog *log = NULL;
+        return log;
+      }
+      static void create() {
+        pointer() = new DumpLog();
+        atexit(flushAtExit);
+      }
+    public:
+      static DumpLog& instance() {
+#if !defined(_WIN32) || defined(__unix__)
+        // readers on several threads may enable dumping at once.
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+        pthread_once(&once, create);
+#else
+        if(!pointer()) create();
+#endif
+        return *pointer();
+      }
+      int openStream(int kind, const char *name, int line, int last) {
+        if(!name) name = "";
+        lock();
+        int id = next_stream++;
+        unlock();
+        put(REC_OPEN, id, name, strlen(name), kind, line, last);
+        return id;
+      }
+      void rename(int stream, const char *name) {
+        if(!name) name = "";
+        put(REC_NAME, stream, name, strlen(name));
+      }
+      void setLine(int stream, int line) {
+        put(REC_LINE, stream, NULL, 0, 0, line);
+      }
+      void data(int stream, const char *p, size_t len) {
+        while(len > 0) {
+          size_t chunk = len < MAX_CHUNK ? len : MAX_CHUNK;
+          put(REC_DATA, stream, p, chunk);
+          p += chunk;
+          len -= chunk;
+        }
+      }
+      void eof(int stream) {
+        put(REC_EOF, stream, NULL, 0);
+      }
+      void close(int stream) {
+        put(REC_CLOSE, stream, NULL, 0);
+      }
+      // waits until everything logged so far has been written out.
+      void flush() {
+        lock();
+        const unsigned long long target = head;
+        while(threaded && drained < target) {
+          notify();
+          wait();
+        }
+        unlock();
+      }
+      // NULL means stderr.
+      void setSink(const char *path) {
+        FILE *fp = stderr;
+        if(path && !(fp = fopen(path, "w"))) {
+          throw std::runtime_error(std::string("error opening dump file: ")+detail::errorString(errno));
+        }
+        // the old sink gets everything logged so far, and is closed only
+        // while the drainer is not writing to it.
+        lock();
+        const unsigned long long target = head;
+        while(threaded && (drained < target || writing)) {
+          notify();
+          wait();
+        }
+        if(owns_sink) fclose(sink);
+        sink = fp;
+        owns_sink = fp != stderr;
+        unlock();
       }
     };
+  }
 
-    class LongData : public DelimiterData<long long> {
-      friend class Reader;
-      LongData(Reader& reader, int delim, long long data)
-        : DelimiterData<long long>(reader,delim,data) {}
+  // Sends IODump output to the given file instead of stderr (NULL: back
+  // to stderr).  Output is written by a background thread; dumps are
+  // complete whenever a reader reaches EOF or reports an error, and after
+  // flushIODump().
+  inline void setIODumpFile(const char *path) {
+    detail::DumpLog::instance().setSink(path);
+  }
+  inline void flushIODump() {
+    detail::DumpLog::instance().flush();
+  }
+
+#ifdef CHECKERLIB_COUNTERS
+  namespace detail {
+    inline long long counterNanos() {
+#if defined(_WIN32) && !defined(__unix__)
+      return (long long)GetTickCount64() * 1000000LL;
+#else
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+    }
+    inline std::string *&countersPath() {
+      static std::string *path = NULL;
+      return path;
+    }
+    inline void initCountersFile() {
+      const char *env = getenv("CHECKERLIB_COUNTERS_FILE");
+      countersPath() = new std::string(env ? env : "");
+    }
+    inline std::string& countersFile() {
+#if !defined(_WIN32) || defined(__unix__)
+      static pthread_once_t once = PTHREAD_ONCE_INIT;
+      pthread_once(&once, initCountersFile);
+#else
+      if(!countersPath()) initCountersFile();
+#endif
+      return *countersPath();
+    }
+  }
+
+  // Where a Reader or Process spends its time; see Reader::counters().
+  // Times are in nanoseconds.
+  struct Counters {
+    long long bytes_read;     // input bytes, read or mapped
+    long long reads;          // read(2) calls
+    long long ints, longs, doubles, strings;  // tokens parsed
+    long long parse_ns;       // in read* calls, less wait_ns and dump_ns
+    long long wait_ns;        // blocked reading (on the child, for Process)
+    long long bytes_written;  // Process only
+    long long flushes;        // write buffer flushes, Process only
+    long long dump_ns;        // handing data to IODump
+    Counters()
+      : bytes_read(0), reads(0), ints(0), longs(0), doubles(0), strings(0),
+        parse_ns(0), wait_ns(0), bytes_written(0), flushes(0), dump_ns(0) {}
+    // One JSON object, on one line; name identifies the stream.
+    std::string toJSON(const char *name) const {
+      std::string json = "{\"name\":\"";
+      for(const char *p = name; *p; p++) {
+        if(*p == '"' || *p == '\\') {
+          json += '\\';
+          json += *p;
+        } else if((unsigned char)*p < ' ') {
+          char esc[8];
+          snprintf(esc, sizeof(esc), "\\u%04x", *p);
+          json += esc;
+        } else {
+          json += *p;
+        }
+      }
+      json += '"';
+      const char *keys[] = {
+        "bytes_read", "reads", "ints", "longs", "doubles", "strings",
+        "parse_ns", "wait_ns", "bytes_written", "flushes", "dump_ns"
+      };
+      const long long vals[] = {
+        bytes_read, reads, ints, longs, doubles, strings,
+        parse_ns, wait_ns, bytes_written, flushes, dump_ns
+      };
+      char num[LTOS_BUFFER_SIZE];
+      for(size_t i = 0; i < sizeof(keys)/sizeof(keys[0]); i++) {
+        json += ",\"";
+        json += keys[i];
+        json += "\":";
+        json += ltos(vals[i], num);
+      }
+      json += "}\n";
+      return json;
+    }
+  };
+
+  // Every Reader appends its counters as a JSON line to this file at
+  // readEof(), and every Process at closeProcess() (NULL: stop).  The
+  // default comes from the CHECKERLIB_COUNTERS_FILE environment variable.
+  inline void setCountersFile(const char *path) {
+    detail::countersFile() = path ? path : "";
+  }
+#endif
+
+#ifdef CHECKERLIB_DECOMPRESS
+  namespace detail {
+    // Decompresses a file for Reader, in place of read(2).  The
+    // compressed data is [in,in_end), refilled from fd unless it is -1
+    // (a mapped file is given whole).
+    class Decoder : private Uncopyable {
+    protected:
+      const char *in, *in_end;
+      int fd;
+      std::vector<char> in_buf;
+      bool refill() {
+        if(fd < 0) return false;
+        if(in_buf.empty()) in_buf.resize(1 << 16);
+        for(;;) {
+          ssize_t n = read(fd, &in_buf[0], in_buf.size());
+          if(n > 0) {
+            in = &in_buf[0];
+            in_end = in + n;
+            return true;
+          }
+          if(n == 0) {
+            fd = -1;
+            return false;
+          }
+          if(errno != EINTR) {
+            throw std::runtime_error(std::string("error reading file: ")+detail::errorString(errno));
+          }
+        }
+      }
     public:
-      LongData range(long long min_val, long long max_val) const {
-        if(! (min_val <= this->getData() && this->getData() <= max_val) ) {
-          this->reader.abortReadingWithError("invalid range");
+      Decoder(const char *data, size_t len, int fd) : in(data), in_end(data + len), fd(fd) {}
+      virtual ~Decoder() {}
+      // Fills [out,out+cap) as far as the data goes; 0 means the end.
+      virtual size_t decode(char *out, size_t cap) = 0;
+      virtual bool threaded() const { return false; }
+    };
+
+#ifdef CHECKERLIB_HAVE_ZLIB
+    // gzip, including files of several concatenated members.
+    class GzipDecoder : public Decoder {
+      z_stream zs;
+      bool member_end;
+    public:
+      GzipDecoder(const char *data, size_t len, int fd) : Decoder(data, len, fd), member_end(false) {
+        memset(&zs, 0, sizeof(zs));
+        if(inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK) {
+          throw std::runtime_error("error reading file: cannot initialize zlib");
         }
-        return *this;
+      }
+      ~GzipDecoder() {
+        inflateEnd(&zs);
+      }
+      size_t decode(char *out, size_t cap) {
+        zs.next_out = (Bytef *)out;
+        zs.avail_out = (uInt)cap;
+        while(zs.avail_out > 0) {
+          if(in == in_end) refill();
+          if(member_end) {
+            if(in == in_end) break;
+            inflateReset(&zs);
+            member_end = false;
+          }
+          zs.next_in = (Bytef *)in;
+          zs.avail_in = (uInt)std::min<size_t>(in_end - in, 1 << 30);
+          int ret = inflate(&zs, Z_NO_FLUSH);
+          in = (const char *)zs.next_in;
+          if(ret == Z_STREAM_END) {
+            member_end = true;
+          } else if(ret == Z_BUF_ERROR && in == in_end) {
+            throw std::runtime_error("error reading file: truncated gzip data");
+          } else if(ret != Z_OK) {
+            throw std::runtime_error(std::string("error reading file: corrupt gzip data: ")+(zs.msg ? zs.msg : "unknown error"));
+          }
+        }
+        return cap - zs.avail_out;
       }
     };
+#endif
 
-    void setVarnameV(const char *format, va_list ap) {
-      vsnprintf(varname, 1000, format, ap);
+#ifdef CHECKERLIB_HAVE_ZSTD
+    class ZstdDecoder : public Decoder {
+      ZSTD_DStream *ds;
+      bool frame_end;
+    public:
+      ZstdDecoder(const char *data, size_t len, int fd) : Decoder(data, len, fd), ds(ZSTD_createDStream()), frame_end(false) {
+        if(!ds || ZSTD_isError(ZSTD_initDStream(ds))) {
+          ZSTD_freeDStream(ds);
+          throw std::runtime_error("error reading file: cannot initialize zstd");
+        }
+      }
+      ~ZstdDecoder() {
+        ZSTD_freeDStream(ds);
+      }
+      size_t decode(char *out, size_t cap) {
+        ZSTD_outBuffer ob = { out, cap, 0 };
+        while(ob.pos < ob.size) {
+          if(in == in_end) refill();
+          if(in == in_end && frame_end) break;
+          ZSTD_inBuffer ib = { in, (size_t)(in_end - in), 0 };
+          const size_t produced = ob.pos;
+          size_t ret = ZSTD_decompressStream(ds, &ob, &ib);
+          if(ZSTD_isError(ret)) {
+            throw std::runtime_error(std::string("error reading file: corrupt zstd data: ")+ZSTD_getErrorName(ret));
+          }
+          in += ib.pos;
+          frame_end = ret == 0;
+          if(!frame_end && in == in_end && ib.pos == 0 && ob.pos == produced) {
+            throw std::runtime_error("error reading file: truncated zstd data");
+          }
+        }
+        return ob.pos;
+      }
+    };
+#endif
+
+    // Runs another decoder on a helper thread, up to BLOCKS blocks ahead
+    // of the reader.  Errors are rethrown in order, after the blocks
+    // decoded before them.
+    class ThreadedDecoder : public Decoder {
+      static const int BLOCKS = 4;
+      static const size_t BLOCK_SIZE = 1 << 16;
+      Decoder *inner;
+      std::vector<char> blocks[BLOCKS];
+      size_t sizes[BLOCKS];
+      int head, count;
+      size_t offset;
+      bool done, stop;
+      std::string error;
+      pthread_mutex_t mutex;
+      pthread_cond_t cond;
+      pthread_t thread;
+      static void *threadMain(void *arg) {
+        static_cast<ThreadedDecoder *>(arg)->run();
+        return NULL;
+      }
+      void run() {
+        for(;;) {
+          pthread_mutex_lock(&mutex);
+          while(count == BLOCKS && !stop) pthread_cond_wait(&cond, &mutex);
+          const int slot = (head + count) % BLOCKS;
+          const bool stopped = stop;
+          pthread_mutex_unlock(&mutex);
+          if(stopped) return;
+          size_t n = 0;
+          std::string what;
+          try {
+            n = inner->decode(&blocks[slot][0], BLOCK_SIZE);
+          } catch(const std::exception& e) {
+            what = e.what();
+          }
+          pthread_mutex_lock(&mutex);
+          if(n > 0) {
+            sizes[slot] = n;
+            count++;
+          } else {
+            done = true;
+            error = what;
+          }
+          pthread_cond_broadcast(&cond);
+          pthread_mutex_unlock(&mutex);
+          if(n == 0) return;
+        }
+      }
+    public:
+      // Takes ownership of inner.  Throws if no thread can be started,
+      // leaving inner to the caller.
+      explicit ThreadedDecoder(Decoder *inner)
+        : Decoder(NULL, 0, -1), inner(inner), head(0), count(0), offset(0), done(false), stop(false) {
+        for(int i = 0; i < BLOCKS; i++) blocks[i].resize(BLOCK_SIZE);
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&cond, NULL);
+        if(pthread_create(&thread, NULL, threadMain, this) != 0) {
+          pthread_cond_destroy(&cond);
+          pthread_mutex_destroy(&mutex);
+          throw std::runtime_error("cannot start a decompression thread");
+        }
+      }
+      ~ThreadedDecoder() {
+        pthread_mutex_lock(&mutex);
+        stop = true;
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(thread, NULL);
+        pthread_cond_destroy(&cond);
+        pthread_mutex_destroy(&mutex);
+        delete inner;
+      }
+      size_t decode(char *out, size_t cap) {
+        pthread_mutex_lock(&mutex);
+        while(count == 0 && !done) pthread_cond_wait(&cond, &mutex);
+        const int slot = head;
+        const bool empty = count == 0;
+        pthread_mutex_unlock(&mutex);
+        if(empty) {
+          if(!error.empty()) throw std::runtime_error(error);
+          return 0;
+        }
+        const size_t n = std::min(cap, sizes[slot] - offset);
+        memcpy(out, &blocks[slot][offset], n);
+        offset += n;
+        if(offset == sizes[slot]) {
+          offset = 0;
+          pthread_mutex_lock(&mutex);
+          head = (head + 1) % BLOCKS;
+          count--;
+          pthread_cond_broadcast(&cond);
+          pthread_mutex_unlock(&mutex);
+        }
+        return n;
+      }
+      bool threaded() const { return true; }
+    };
+  }
+#endif
+
+#ifdef CHECKERLIB_CXX11
+  namespace schema {
+    struct Access;
+  }
+#endif
+
+  class Reader : private Uncopyable {
+    friend class TokenData;
+    friend class Process;
+    friend class ProcessPool;
+    friend class Comparator;
+    friend class BatchValidator;
+#ifdef CHECKERLIB_CXX11
+    friend struct schema::Access;
+#endif
+    static const int READ_BUFFER_SIZE = 1 << 16;
+    static const int PARALLEL_MIN_RECORDS = 1 << 16;
+    int parallel_threads;
+    int internal_fd;
+    // The descriptor readEof() last closed (-1: none); abortReading()
+    // leaves closing to the owner of the file.
+    int closed_fd;
+    char *filename;
+    // Positions are not tracked per character.  Consumed input is folded
+    // into a newline count and the number of characters since the last
+    // newline whenever a block is discarded or a position is requested.
+    // The most recently returned character (or -1 for EOF) is kept apart
+    // in pos_pending, since it does not count toward the line yet.
+    int pos_lines, pos_since;
+    int pos_pending;
+    const char *pos_scanned;
+    // IODump stream id (-1: not dumping); input before dump_from has
+    // been handed to the dump log already.
+    int dump_stream;
+    const char *dump_from;
+    // Backing store for string views that cross a block boundary.
+    std::string token_spill;
+    char *varname;
+    // Variable names are formatted lazily: readInt/readLong only record
+    // the format and its (integer) arguments, and varname is filled in
+    // when positionDescription() actually needs it.  The format string
+    // is copied into varname_spec, since the caller's may be a temporary;
+    // longer formats are formatted eagerly.
+    enum {
+      VARARG_LITERAL, VARARG_INT, VARARG_UINT, VARARG_LONG, VARARG_ULONG,
+      VARARG_LLONG, VARARG_ULLONG, VARARG_SIZE, VARARG_PTRDIFF, VARARG_PTR,
+      VARARG_WINT, VARARG_UNSUPPORTED
+    };
+    static const int VARNAME_MAX_ARGS = 8;
+    static const int VARNAME_SPEC_SIZE = 128;
+    union VarnameArg {
+      int i; unsigned int u; long l; unsigned long ul;
+      long long ll; unsigned long long ull;
+      size_t z; ptrdiff_t t; const void *p; wint_t wc;
+    };
+    const char *varname_format;
+    char varname_spec[VARNAME_SPEC_SIZE];
+    int varname_types[VARNAME_MAX_ARGS];
+    VarnameArg varname_args[VARNAME_MAX_ARGS];
+    char *buf;
+    const char *cur, *end;
+    bool eof;
+#if defined(_WIN32) && !defined(__unix__)
+    bool after_cr;
+#endif
+    void *mapping;
+    size_t mapping_size;
+    // Per-read deadline in milliseconds (-1: none) and the time spent
+    // blocked in read (-1: not measured); used by Process.
+    int read_timeout_ms;
+    bool read_timed_out;
+    long long read_wait_ns;
+#ifdef CHECKERLIB_DECOMPRESS
+    // Set while reading a compressed file; buf then holds decompressed
+    // data and the mapping, if any, the compressed file.
+    detail::Decoder *decoder;
+#endif
+#ifdef CHECKERLIB_COUNTERS
+    Counters stats;
+    // Set by Process, which reports its counters at closeProcess().
+    bool stats_deferred;
+    // Charges the time of one read* call, less waiting and IODump, to
+    // parse_ns.
+    class ParseTimer {
+      Counters& stats;
+      long long start;
+      static long long now(const Counters& stats) {
+        return detail::counterNanos() - stats.wait_ns - stats.dump_ns;
+      }
+    public:
+      ParseTimer(Counters& stats, long long& tokens, long long n)
+        : stats(stats), start(now(stats)) {
+        tokens += n;
+      }
+      ~ParseTimer() {
+        stats.parse_ns += now(stats) - start;
+      }
+    };
+    long long& tokenCount(const int *) { return stats.ints; }
+    long long& tokenCount(const long long *) { return stats.longs; }
+    void reportCounters() {
+      const std::string& path = detail::countersFile();
+      if(path.empty()) return;
+      FILE *fp = fopen(path.c_str(), "a");
+      if(!fp) return;
+      fputs(stats.toJSON(filename).c_str(), fp);
+      fclose(fp);
     }
-    IntData readInt(const char *format = "<?>", ...) ATTR_PRINTF(2,3) {
-      va_list ap;
-      va_start(ap, format);
-      setVarnameV(format, ap);
-      va_end(ap);
+#endif
+    void init() {
+      internal_fd = -1;
+      closed_fd = -1;
+      parallel_threads = 1;
+      filename = NULL;
+      pos_lines = 0;
+      pos_since = 0;
+      pos_pending = -2;
+      pos_scanned = NULL;
+      dump_stream = -1;
+      dump_from = NULL;
+      varname = new char[1000];
+      varname_format = NULL;
+      buf = NULL;
+      cur = end = NULL;
+      eof = false;
+#if defined(_WIN32) && !defined(__unix__)
+      after_cr = false;
+#endif
+      mapping = NULL;
+      mapping_size = 0;
+      read_timeout_ms = -1;
+      read_timed_out = false;
+      read_wait_ns = -1;
+#ifdef CHECKERLIB_DECOMPRESS
+      decoder = NULL;
+#endif
+      CHECKERLIB_COUNT(stats_deferred = false);
+    }
+    void open(int fd, const char *filename) {
+      if(internal_fd >= 0) throw std::domain_error("Reader::open(int,const char*): already opened.");
+      if(fd < 0) throw std::invalid_argument("Reader::open(int,const char*): fd is invalid.");
+      if(!filename) throw std::invalid_argument("Reader::open(int,const char*): filename is NULL.");
 
-      int i;
-      int c = readChar();
+      this->internal_fd = fd;
+      int filename_len = std::min<int>(1000,strlen(filename)+1);
+      delete[] this->filename;
+      this->filename = new char[filename_len];
+      strncpy(this->filename, filename, filename_len);
+      strcpy(varname, "<init>");
+      varname_format = NULL;
+      foldPosition(cur);
+      logConsumed();
+      CHECKERLIB_COUNT(stats = Counters());
+#ifdef CHECKERLIB_DECOMPRESS
+      delete decoder;
+      decoder = NULL;
+#endif
+      unmap();
+      eof = false;
+      if(!map(fd)) {
+        if(!buf) buf = new char[READ_BUFFER_SIZE];
+        cur = end = buf;
+      }
+      pos_scanned = dump_from = cur;
+      if(dump_stream >= 0) detail::DumpLog::instance().rename(dump_stream, this->filename);
+    }
+    // hands the input consumed since the last call to the dump log.
+    void logConsumed() {
+      if(dump_stream >= 0 && cur != dump_from) {
+        CHECKERLIB_COUNT(const long long dump_start = detail::counterNanos());
+        detail::DumpLog::instance().data(dump_stream, dump_from, cur - dump_from);
+        CHECKERLIB_COUNT(stats.dump_ns += detail::counterNanos() - dump_start);
+      }
+      dump_from = cur;
+    }
+    void syncIODump() {
+      if(dump_stream >= 0) {
+        logConsumed();
+        CHECKERLIB_COUNT(const long long dump_start = detail::counterNanos());
+        detail::DumpLog::instance().flush();
+        CHECKERLIB_COUNT(stats.dump_ns += detail::counterNanos() - dump_start);
+      }
+    }
+    // Regular files (including a redirected stdin) are mapped as a whole
+    // and parsed in place; anything else is streamed through buf.
+    bool map(int fd) {
+#if defined(_WIN32) && !defined(__unix__)
+      (void)fd;
+      return false;
+#else
+      struct stat st;
+      if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) return false;
+      off_t offset = lseek(fd, 0, SEEK_CUR);
+      if(offset < 0 || st.st_size <= offset) return false;
+      if((unsigned long long)st.st_size > (size_t)-1) return false;
+      void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(addr == MAP_FAILED) return false;
+      madvise(addr, st.st_size, MADV_SEQUENTIAL);
+      mapping = addr;
+      mapping_size = st.st_size;
+      CHECKERLIB_COUNT(stats.bytes_read += st.st_size - offset);
+      cur = (const char *)addr + offset;
+      end = (const char *)addr + st.st_size;
+      eof = true;
+      return true;
+#endif
+    }
+    void unmap() {
+#if !defined(_WIN32) || defined(__unix__)
+      if(mapping) {
+        munmap(mapping, mapping_size);
+        mapping = NULL;
+        mapping_size = 0;
+        cur = end = pos_scanned = NULL;
+      }
+#endif
+    }
+    void foldChar(int c) {
+      if(c == '\n') {
+        pos_lines++;
+        pos_since = 0;
+      } else {
+        pos_since++;
+      }
+    }
+    // folds everything consumed before upto, which must lie in the
+    // current block, into the position counters.
+    void foldPosition(const char *upto) {
+      if(upto == pos_scanned) return;
+      if(pos_pending != -2) foldChar(pos_pending);
+      const char *last = upto - 1;
+      const char *p = pos_scanned;
+      const char *nl;
+      while((nl = (const char *)memchr(p, '\n', last - p))) {
+        pos_lines++;
+        p = nl + 1;
+      }
+      pos_since = (p == pos_scanned ? pos_since : 0) + (last - p);
+      pos_pending = (unsigned char)*last;
+      pos_scanned = upto;
+    }
+    void currentPosition(int& line, int& col) {
+      foldPosition(cur);
+      if(pos_pending == -2) {
+        line = -1;
+        col = 0;
+      } else {
+        line = pos_lines - 1;
+        col = pos_since + 1;
+      }
+    }
+#if !defined(_WIN32) || defined(__unix__)
+    static long long monotonicNanos() {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+    // blocks until input is available, or throws once read_timeout_ms
+    // has passed without any.
+    void waitReadable() {
+      const long long deadline = monotonicNanos() + read_timeout_ms * 1000000LL;
+      for(;;) {
+        long long remaining = std::max(0LL, (deadline - monotonicNanos() + 999999) / 1000000);
+        struct pollfd pfd;
+        pfd.fd = internal_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ret = poll(&pfd, 1, (int)remaining);
+        if(ret > 0) return;
+        if(ret == 0) {
+          syncIODump();
+          abortReading();
+          read_timed_out = true;
+          throw TimeLimitExceeded(std::string(filename)+": no output within "+itos(read_timeout_ms)+" ms");
+        }
+        if(errno != EINTR) {
+          throw std::runtime_error(std::string("error reading file: ")+detail::errorString(errno));
+        }
+      }
+    }
+#endif
+    // refills the buffer with the next block; returns false on EOF.
+#ifdef CHECKERLIB_DECOMPRESS
+    // Truncated or corrupt compressed data ends the reading: the file is
+    // closed, so that the Reader can still be disposed of as the error
+    // propagates.
+    void closeAfterError() {
+      const int fd = internal_fd;
+      abortReading();
+      eof = true;
+      cur = end = buf;
+      if(fd >= 0) {
+        close(fd);
+        closed_fd = fd;
+      }
+    }
+#endif
+    bool fill() {
+      if(eof) return false;
+      foldPosition(cur);
+      logConsumed();
+      for(;;) {
+        CHECKERLIB_COUNT(const long long read_start = detail::counterNanos());
+#if !defined(_WIN32) || defined(__unix__)
+        const long long wait_start = read_wait_ns >= 0 ? monotonicNanos() : 0;
+        if(read_timeout_ms >= 0) waitReadable();
+#ifdef CHECKERLIB_DECOMPRESS
+        ssize_t n;
+        if(decoder) {
+          try {
+            n = (ssize_t)decoder->decode(buf, READ_BUFFER_SIZE);
+          } catch(...) {
+            closeAfterError();
+            throw;
+          }
+        } else {
+          n = read(internal_fd, buf, READ_BUFFER_SIZE);
+        }
+#else
+        ssize_t n = read(internal_fd, buf, READ_BUFFER_SIZE);
+#endif
+        if(read_wait_ns >= 0) read_wait_ns += monotonicNanos() - wait_start;
+#else
+        ssize_t n = read(internal_fd, buf, READ_BUFFER_SIZE);
+#endif
+        CHECKERLIB_COUNT(stats.wait_ns += detail::counterNanos() - read_start);
+        CHECKERLIB_COUNT(stats.reads++);
+        CHECKERLIB_COUNT(if(n > 0) stats.bytes_read += n);
+#if defined(_WIN32) && !defined(__unix__)
+        // a CR is dropped, and the character following it kept as is.
+        if(n > 0) {
+          char *w = buf;
+          for(const char *r = buf; r != buf + n; r++) {
+            if(!after_cr && *r == '\r') {
+              after_cr = true;
+            } else {
+              after_cr = false;
+              *w++ = *r;
+            }
+          }
+          n = w - buf;
+          if(n == 0) continue;
+        }
+#endif
+        if(n > 0) {
+          cur = pos_scanned = dump_from = buf;
+          end = buf + n;
+          return true;
+        }
+        if(n == 0) {
+          eof = true;
+          return false;
+        }
+        if(errno != EINTR) {
+          throw std::runtime_error(std::string("error reading file: ")+detail::errorString(errno));
+        }
+      }
+    }
+    int readEofChar() {
+      foldPosition(cur);
+      if(pos_pending != -2) foldChar(pos_pending);
+      pos_pending = -1;
+      if(dump_stream >= 0) {
+        logConsumed();
+        detail::DumpLog::instance().eof(dump_stream);
+      }
+      return -1;
+    }
+    int readChar() {
+      return (cur != end || fill()) ? (unsigned char)*cur++ : readEofChar();
+    }
+    // consumes [cur,p), which must be non-empty and free of newlines.
+    void advance(const char *p) {
+      cur = p;
+    }
+    static bool isSpace(char c) {
+      return (unsigned char)c <= ' ' &&
+        (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f');
+    }
+    // Reads the run of members of cs at the cursor, leaving the byte
+    // after it unread.  The view points into the buffer, or into
+    // token_spill if the run crosses a block boundary.
+    StringView readSpan(const Charset& cs) {
+      const char *p = cur + cs.span(cur, end);
+      if(p != end) {
+        StringView s(cur, p - cur);
+        cur = p;
+        return s;
+      }
+      token_spill.assign(cur, p);
+      cur = p;
+      while(fill()) {
+        p = cur + cs.span(cur, end);
+        token_spill.append(cur, p);
+        cur = p;
+        if(p != end) break;
+      }
+      return StringView(token_spill.data(), token_spill.size());
+    }
+    static const Charset& tokenCharset() {
+      static const Charset cs = Charset().add(0, 8).add(14, 31).add(33, 255);
+      return cs;
+    }
+    static const Charset& lineCharset() {
+      static const Charset cs = Charset().add(0, 9).add(11, 255);
+      return cs;
+    }
+    // the characters that can occur in a real number.
+    static const Charset& realCharset() {
+      static const Charset cs("0-9.+eE-");
+      return cs;
+    }
+    // readString/readLine: after the run of members of cs, the next byte
+    // must be EOF or satisfy is_delim.
+    StringView readChecked(size_t min_len, size_t max_len, const Charset& cs, bool (*is_delim)(char)) {
+      StringView s = readSpan(cs);
+      if(cur != end && !is_delim(*cur)) {
+        abortInvalidCharacter(*cur);
+      }
+      if(s.size() < min_len || s.size() > max_len) {
+        abortReadingWithError("invalid length");
+      }
+      return s;
+    }
+    static bool isNewline(char c) {
+      return c == '\n';
+    }
+    void parseReal(int max_decimals, bool allow_exponent, double& val, int& c) {
+      StringView tok = readSpan(realCharset());
+      const char *err = detail::parseRealAt(tok.begin(), tok.end(), max_decimals, allow_exponent, val);
+      if(err) {
+        abortReadingWithError(err);
+      }
+      c = readChar();
+    }
+    // Parses a token that lies entirely in the buffer.  Returns false
+    // without consuming anything if the token is not a well-formed
+    // in-range integer, or may continue past the buffered block; the
+    // character-wise path then takes over and reports errors.
+    template<typename T>
+    bool parseIntegerFast(T& i, int& c) {
+      const char *p = cur;
+      if(!detail::parseIntegerAt(p, end, i)) return false;
+      advance(p);
+      c = readChar();
+      return true;
+    }
+    // Character-wise parsers behind readInt/readLong; these produce all
+    // of the integer error messages.
+    void parseInteger(int& i, int& c) {
+      if(parseIntegerFast(i, c)) {
+        return;
+      }
+      c = readChar();
       if(c == '-') {
         c = readChar();
         if('1' <= c && c <= '9') {
@@ -359,14 +1825,14 @@ namespace checker {
               }
               i = i*10 - (c - '0');
             } else {
-              return IntData(*this, c, i);
+              return;
             }
           }
         }
       } else if(c == '0') {
         i = 0;
         c = readChar();
-        return IntData(*this, c, i);
+        return;
       } else if('1' <= c && c <= '9') {
         i = (c - '0');
         for(;;) {
@@ -377,21 +1843,18 @@ namespace checker {
             }
             i = i*10 + (c - '0');
           } else {
-            return IntData(*this, c, i);
+            return;
           }
         }
       }
       abortReadingWithError("error reading int: not an integer input");
     }
 
-    LongData readLong(const char *format = "<?>", ...) ATTR_PRINTF(2,3) {
-      va_list ap;
-      va_start(ap, format);
-      setVarnameV(format, ap);
-      va_end(ap);
-
-      long long i;
-      int c = readChar();
+    void parseInteger(long long& i, int& c) {
+      if(parseIntegerFast(i, c)) {
+        return;
+      }
+      c = readChar();
       if(c == '-') {
         c = readChar();
         if('1' <= c && c <= '9') {
@@ -404,14 +1867,14 @@ namespace checker {
               }
               i = i*10 - (c - '0');
             } else {
-              return LongData(*this, c, i);
+              return;
             }
           }
         }
       } else if(c == '0') {
         i = 0;
         c = readChar();
-        return LongData(*this, c, i);
+        return;
       } else if('1' <= c && c <= '9') {
         i = (c - '0');
         for(;;) {
@@ -422,255 +1885,2940 @@ namespace checker {
             }
             i = i*10 + (c - '0');
           } else {
-            return LongData(*this, c, i);
+            return;
           }
         }
       }
       abortReadingWithError("error reading long long: not an integer input");
     }
 
-    void readEof() {
-      if(readChar() != -1) {
-        internal_fp = NULL;
-        abortReadingWithError("error reading EOF: not an EOF");
+    // Bulk reading: the variable name is only materialized when an
+    // element fails, and the checks of readX(...).range(...).spc()/eol()
+    // are fused into one loop.
+    void setVarnameIndexed(const char *name, int idx) {
+      char idx_buf[ITOS_BUFFER_SIZE];
+      const size_t len = std::min<size_t>(strlen(name), 1000 - ITOS_BUFFER_SIZE - 3);
+      memcpy(varname, name, len);
+      varname[len] = '[';
+      strcpy(varname + len + 1, itos(idx, idx_buf));
+      strcat(varname + len + 1, "]");
+      varname_format = NULL;
+    }
+    template<typename T>
+    T readElement(T min_val, T max_val, int delim, const char *name, int idx) {
+      T val;
+      int c;
+      if(!parseIntegerFast(val, c)) {
+        setVarnameIndexed(name, idx);
+        parseInteger(val, c);
       }
-      if(ferror(internal_fp)) {
-        internal_fp = NULL;
-        throw std::runtime_error(std::string("error reading file: ")+strerror(errno));
+      if(!(min_val <= val && val <= max_val)) {
+        setVarnameIndexed(name, idx);
+        abortReadingWithError("invalid range");
       }
-      if(fclose(internal_fp)==EOF) {
-        internal_fp = NULL;
-        throw std::runtime_error(std::string("error reading file: ")+strerror(errno));
+      if(c != delim) {
+        setVarnameIndexed(name, idx);
+        abortReadingWithError(delim == '\n' ? "delimiter EOL is expected" : "delimiter SPC is expected");
       }
-      internal_fp = NULL;
+      return val;
     }
-
-    void enableIODump() {
-      if(!linecache) {
-        linecache = new std::string();
+    // Parallel bulk reading of n one-line records from a mapped file.
+    // Returns how many leading records were read; the caller continues
+    // sequentially from there.  The records of a chunk that the fast path
+    // could not take are read sequentially in place, which also produces
+    // the exact error; the following chunks are kept as long as that
+    // ends at their start.
+    template<typename T>
+    int readRecordsParallel(T *xs, T *ys, int n, T min_val, T max_val, const char *xname, const char *yname) {
+      if(parallel_threads <= 1 || !mapping || dump_stream >= 0 || n < PARALLEL_MIN_RECORDS) return 0;
+#ifdef CHECKERLIB_DECOMPRESS
+      if(decoder) return 0;
+#endif
+      int nchunks = parallel_threads;
+      std::vector<detail::RecordChunk<T> > chunks(nchunks);
+      const char *p = cur;
+      for(int t = 0; t < nchunks; t++) {
+        const char *q = t+1 == nchunks ? end : cur + (end - cur) / nchunks * (t+1);
+        if(q < p) q = p;
+        const char *nl = q == end ? NULL : (const char *)memchr(q, '\n', end - q);
+        q = nl ? nl + 1 : end;
+        chunks[t].begin = p;
+        chunks[t].end = q;
+        p = q;
       }
+      detail::runParallel(&chunks[0], nchunks, detail::RecordChunk<T>::countLines);
+      int first = 0;
+      for(int t = 0; t < nchunks; t++) {
+        chunks[t].first = first;
+        chunks[t].count = std::min(chunks[t].lines, n - first);
+        chunks[t].parsed = 0;
+        chunks[t].stop = chunks[t].begin;
+        chunks[t].xs = xs;
+        chunks[t].ys = ys;
+        chunks[t].min_val = min_val;
+        chunks[t].max_val = max_val;
+        first += chunks[t].count;
+      }
+      detail::runParallel(&chunks[0], nchunks, detail::RecordChunk<T>::parseRecords);
+      int done = 0;
+      for(int t = 0; t < nchunks && chunks[t].count > 0 && cur == chunks[t].begin; t++) {
+        const detail::RecordChunk<T>& chunk = chunks[t];
+        cur = chunk.stop;
+        for(done = chunk.first + chunk.parsed; done < chunk.first + chunk.count; done++) {
+          if(ys) {
+            xs[done] = readElement(min_val, max_val, ' ', xname, done);
+            ys[done] = readElement(min_val, max_val, '\n', yname, done);
+          } else {
+            xs[done] = readElement(min_val, max_val, '\n', xname, done);
+          }
+        }
+      }
+      return done;
     }
-  };
-
-  ////
-  //// Tools for Reactive
-  ////
-  class Process : public Reader {
-    const char *arg0;
-    std::vector<const char *> args;
-    char *procname;
-    FILE *write_file;
-    FILE *read_file;
-    pid_t pid;
-    int line;
-    std::string *linecache;
-    char *prtcache;
-    void init() {
-      arg0 = NULL;
-      args.clear();
-      procname = NULL;
-      write_file = NULL;
-      read_file = NULL;
-      pid = 0;
-      line = 1;
-      linecache = NULL;
-      prtcache = NULL;
-    }
-  public:
-    void execute() {
-      if(pid) throw std::domain_error("Process::execute(): already executed.");
-      if(args.empty()) throw std::domain_error("Process::execute(): args is empty");
-      const char *file = arg0 ? arg0 : args[0];
-      FILE *read_file;
-      FILE *write_file;
-      int pid;
-      int pipe_c2p[2], pipe_p2c[2];
-
-      signal(SIGPIPE, SIG_IGN);
-      if (pipe(pipe_c2p) < 0 || pipe(pipe_p2c) < 0) {
-        throw std::runtime_error(std::string("error creating pipe: ")+strerror(errno));
+    template<typename T>
+    void readArray(T *out, int n, T min_val, T max_val, int sep, const char *name) {
+      if(n < 0) throw std::invalid_argument("Reader::readArray: n is negative");
+      CHECKERLIB_COUNT(ParseTimer timer(stats, tokenCount(out), n));
+      int i = 0;
+      if(sep == '\n') {
+        i = readRecordsParallel(out, (T *)NULL, n, min_val, max_val, name, name);
       }
-      if ((pid = fork()) < 0) {
-        throw std::runtime_error(std::string("error forking process: ")+strerror(errno));
+      for(; i+1 < n; i++) {
+        out[i] = readElement(min_val, max_val, sep, name, i);
       }
-      if (pid == 0) {
-        close(pipe_p2c[1]); close(pipe_c2p[0]);
+      if(i < n) {
+        out[n-1] = readElement(min_val, max_val, '\n', name, n-1);
+      }
+      if(n > 0) {
+        setVarnameIndexed(name, n-1);
+      }
+    }
+    template<typename T>
+    void readPairs(T *xs, T *ys, int n, T min_val, T max_val, const char *xname, const char *yname) {
+      if(n < 0) throw std::invalid_argument("Reader::readPairs: n is negative");
+      CHECKERLIB_COUNT(ParseTimer timer(stats, tokenCount(xs), 2LL * n));
+      for(int i = readRecordsParallel(xs, ys, n, min_val, max_val, xname, yname); i < n; i++) {
+        xs[i] = readElement(min_val, max_val, ' ', xname, i);
+        ys[i] = readElement(min_val, max_val, '\n', yname, i);
+      }
+      if(n > 0) {
+        setVarnameIndexed(yname, n-1);
+      }
+    }
+    // Switches to decompressing the file just opened by name if it starts
+    // with a gzip or zstd signature.  Positions, IODump and counters all
+    // refer to the decompressed data.
+    void detectCompression() {
+#ifdef CHECKERLIB_DECOMPRESS
+      unsigned char magic[4];
+      ssize_t len;
+      if(mapping) {
+        len = std::min<ssize_t>(4, end - cur);
+        memcpy(magic, cur, len);
+      } else {
+        len = pread(internal_fd, magic, 4, 0);
+      }
+      detail::Decoder *d = NULL;
+      const char *data = mapping ? cur : NULL;
+      const size_t size = mapping ? end - cur : 0;
+      const int fd = mapping ? -1 : internal_fd;
+      try {
+#ifdef CHECKERLIB_HAVE_ZLIB
+        if(len >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+          d = new detail::GzipDecoder(data, size, fd);
+        }
+#endif
+#ifdef CHECKERLIB_HAVE_ZSTD
+        if(len >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+          d = new detail::ZstdDecoder(data, size, fd);
+        }
+#endif
+        if(!d) return;
+        decoder = d;
+        if(!buf) buf = new char[READ_BUFFER_SIZE];
+      } catch(...) {
+        closeAfterError();
+        throw;
+      }
+      cur = end = pos_scanned = dump_from = buf;
+      eof = false;
+      CHECKERLIB_COUNT(stats.bytes_read = 0);
+#endif
+    }
+  public:
+    Reader() {
+      init();
+    }
+    // Decompresses on a helper thread, overlapping with parsing.  No
+    // effect unless the input is compressed.
+    void enableDecompressionThread() {
+#ifdef CHECKERLIB_DECOMPRESS
+      if(decoder && !decoder->threaded()) {
+        try {
+          decoder = new detail::ThreadedDecoder(decoder);
+        } catch(const std::runtime_error&) {
+          // keep decompressing inline
+        }
+      }
+#endif
+    }
+    void open(const char *filename) {
+      int fd = ::open(filename, O_RDONLY);
+      if(fd >= 0) {
+        open(fd, filename);
+        detectCompression();
+      } else {
+        throw std::runtime_error(std::string("Reader::open(const char*): error opening file: ")+detail::errorString(errno));
+      }
+    }
+    Reader(FILE *fp) {
+      if(fp==stdin) {
+        init();
+        open(fileno(stdin), "<stdin>");
+      } else {
+        throw std::invalid_argument("Reader(FILE*): fp must be stdin.");
+      }
+    }
+    Reader(const char *filename) {
+      int fd = ::open(filename, O_RDONLY);
+      if(fd >= 0) {
+        init();
+        try {
+          open(fd, filename);
+          detectCompression();
+        } catch(...) {
+          // the destructor does not run for a half-constructed Reader.
+          if(closed_fd != fd) close(fd);
+          release();
+          throw;
+        }
+      } else {
+        throw std::runtime_error(std::string("Reader(const char*): error opening file: ")+detail::errorString(errno));
+      }
+    }
+    void dispose() {
+      if(internal_fd >= 0) {
+        throw std::logic_error(std::string(filename)+": call readEof() or abortReading() before disposing!");
+      }
+    }
+    ~Reader() CHECKERLIB_THROWING_DTOR {
+      dispose();
+      release();
+    }
+  private:
+    // frees everything but the file, which dispose() checks for.
+    void release() {
+      if(dump_stream >= 0) {
+        logConsumed();
+        detail::DumpLog::instance().close(dump_stream);
+      }
+      delete[] varname;
+      delete[] filename;
+      delete[] buf;
+#ifdef CHECKERLIB_DECOMPRESS
+      delete decoder;
+#endif
+      unmap();
+    }
+  public:
+    std::string positionDescription() {
+      formatVarname();
+      int line, col;
+      currentPosition(line, col);
+      char line_buf[ITOS_BUFFER_SIZE], col_buf[ITOS_BUFFER_SIZE];
+      std::string desc(filename);
+      desc += '(';
+      desc += itos(line, line_buf);
+      desc += ',';
+      desc += itos(col, col_buf);
+      desc += ',';
+      desc += varname;
+      desc += "): ";
+      return desc;
+    }
+    void abortReading() {
+      internal_fd = -1;
+    }
+    void abortReadingWithError(const std::string& str) ATTR_NORETURN {
+      syncIODump();
+      abortReading();
+      throw ParseError(positionDescription()+str);
+    }
+    void abortInvalidCharacter(unsigned char c) ATTR_NORETURN {
+      static const char hex[] = "0123456789abcdef";
+      std::string msg = "invalid character ";
+      if(' ' < c && c < 127) {
+        msg += '\'';
+        msg += (char)c;
+        msg += '\'';
+      } else {
+        msg += "\\x";
+        msg += hex[c >> 4];
+        msg += hex[c & 15];
+      }
+      abortReadingWithError(msg);
+    }
+
+    template<typename T>
+    class DelimiterData {
+      friend class Reader;
+    protected:
+      Reader& reader;
+      int delim;
+      T data;
+      DelimiterData(Reader& reader, int delim, T data)
+        : reader(reader), delim(delim), data(data) {}
+    public:
+      int getDelim() const { return this->delim; }
+      T getData() const { return this->data; }
+      Reader& getReader() const { return this->reader; }
+      T eol() const {
+        if(delim!='\n') {
+          reader.abortReadingWithError("delimiter EOL is expected");
+        }
+        return data;
+      }
+      T spc() const {
+        if(delim!=' ') {
+          reader.abortReadingWithError("delimiter SPC is expected");
+        }
+        return data;
+      }
+      T ary(int i, int n) const {
+        if(i<0 || i >=n) {
+          throw std::invalid_argument("DelimiterData::ary(int,int): invalid condition");
+        }
+        if(i+1==n) {
+          return this->eol();
+        } else {
+          return this->spc();
+        }
+      }
+    };
+
+    class IntData : public DelimiterData<int> {
+      friend class Reader;
+      IntData(Reader& reader, int delim, int data)
+        : DelimiterData<int>(reader,delim,data) {}
+    public:
+      IntData range(int min_val, int max_val) const {
+        if(! (min_val <= this->getData() && this->getData() <= max_val) ) {
+          this->reader.abortReadingWithError("invalid range");
+        }
+        return *this;
+      }
+    };
+
+    class LongData : public DelimiterData<long long> {
+      friend class Reader;
+      LongData(Reader& reader, int delim, long long data)
+        : DelimiterData<long long>(reader,delim,data) {}
+    public:
+      LongData range(long long min_val, long long max_val) const {
+        if(! (min_val <= this->getData() && this->getData() <= max_val) ) {
+          this->reader.abortReadingWithError("invalid range");
+        }
+        return *this;
+      }
+    };
+
+    class StringData : public DelimiterData<StringView> {
+      friend class Reader;
+      StringData(Reader& reader, int delim, StringView data)
+        : DelimiterData<StringView>(reader,delim,data) {}
+    public:
+      StringData length(size_t min_len, size_t max_len) const {
+        if(! (min_len <= this->data.size() && this->data.size() <= max_len) ) {
+          this->reader.abortReadingWithError("invalid length");
+        }
+        return *this;
+      }
+      StringData charset(const Charset& cs) const {
+        size_t n = cs.span(this->data.begin(), this->data.end());
+        if(n != this->data.size()) {
+          this->reader.abortInvalidCharacter(this->data[n]);
+        }
+        return *this;
+      }
+    };
+
+    class DoubleData : public DelimiterData<double> {
+      friend class Reader;
+      DoubleData(Reader& reader, int delim, double data)
+        : DelimiterData<double>(reader,delim,data) {}
+    public:
+      DoubleData range(double min_val, double max_val) const {
+        if(! (min_val <= this->getData() && this->getData() <= max_val) ) {
+          this->reader.abortReadingWithError("invalid range");
+        }
+        return *this;
+      }
+    };
+
+    // Scans the conversion specification following a '%' and returns
+    // the type of its argument.  Only integer and pointer conversions are
+    // deferred; anything else (%s, floating point, '*' widths, ...) is
+    // reported as unsupported and formatted eagerly.
+    static int scanConversion(const char *&p) {
+      if(*p == '%') {
+        p++;
+        return VARARG_LITERAL;
+      }
+      while(*p && strchr("-+ #0", *p)) p++;
+      while('0' <= *p && *p <= '9') p++;
+      if(*p == '.') {
+        p++;
+        while('0' <= *p && *p <= '9') p++;
+      }
+      int length = 0;
+      if(*p == 'h') {
+        p++;
+        if(*p == 'h') p++;
+      } else if(*p == 'l') {
+        p++;
+        length = 1;
+        if(*p == 'l') {
+          p++;
+          length = 2;
+        }
+      } else if(*p == 'z') {
+        p++;
+        length = 3;
+      } else if(*p == 't') {
+        p++;
+        length = 4;
+      }
+      char conv = *p;
+      if(!conv) return VARARG_UNSUPPORTED;
+      p++;
+      if(conv == 'p') {
+        return length == 0 ? VARARG_PTR : VARARG_UNSUPPORTED;
+      }
+      if(conv == 'c' && length == 1) return VARARG_WINT;
+      bool is_signed;
+      if(conv == 'd' || conv == 'i') {
+        is_signed = true;
+      } else if(conv == 'u' || conv == 'o' || conv == 'x' || conv == 'X' || conv == 'c') {
+        is_signed = conv == 'c';
+      } else {
+        return VARARG_UNSUPPORTED;
+      }
+      switch(length) {
+        case 0: return is_signed ? VARARG_INT : VARARG_UINT;
+        case 1: return is_signed ? VARARG_LONG : VARARG_ULONG;
+        case 2: return is_signed ? VARARG_LLONG : VARARG_ULLONG;
+        case 3: return VARARG_SIZE;
+        default: return VARARG_PTRDIFF;
+      }
+    }
+    void setVarnameV(const char *format, va_list ap) {
+      const size_t len = strlen(format);
+      if(len >= (size_t)VARNAME_SPEC_SIZE) {
+        vsnprintf(varname, 1000, format, ap);
+        varname_format = NULL;
+        return;
+      }
+      int nargs = 0;
+      for(const char *p = format; (p = strchr(p, '%')); ) {
+        const char *spec = p++;
+        int type = scanConversion(p);
+        if(type == VARARG_LITERAL) continue;
+        if(type == VARARG_UNSUPPORTED || nargs == VARNAME_MAX_ARGS || p - spec >= 32) {
+          vsnprintf(varname, 1000, format, ap);
+          varname_format = NULL;
+          return;
+        }
+        varname_types[nargs++] = type;
+      }
+      for(int k = 0; k < nargs; k++) {
+        VarnameArg& arg = varname_args[k];
+        switch(varname_types[k]) {
+          case VARARG_INT: arg.i = va_arg(ap, int); break;
+          case VARARG_UINT: arg.u = va_arg(ap, unsigned int); break;
+          case VARARG_LONG: arg.l = va_arg(ap, long); break;
+          case VARARG_ULONG: arg.ul = va_arg(ap, unsigned long); break;
+          case VARARG_LLONG: arg.ll = va_arg(ap, long long); break;
+          case VARARG_ULLONG: arg.ull = va_arg(ap, unsigned long long); break;
+          case VARARG_SIZE: arg.z = va_arg(ap, size_t); break;
+          case VARARG_PTRDIFF: arg.t = va_arg(ap, ptrdiff_t); break;
+          case VARARG_PTR: arg.p = va_arg(ap, const void *); break;
+          case VARARG_WINT: arg.wc = va_arg(ap, wint_t); break;
+        }
+      }
+      memcpy(varname_spec, format, len + 1);
+      varname_format = varname_spec;
+    }
+    void formatVarname() {
+      if(!varname_format) return;
+      const char *p = varname_format;
+      varname_format = NULL;
+      int pos = 0, k = 0;
+      while(*p && pos < 999) {
+        if(*p != '%') {
+          varname[pos++] = *p++;
+          continue;
+        }
+        const char *spec_begin = p++;
+        if(scanConversion(p) == VARARG_LITERAL) {
+          varname[pos++] = '%';
+          continue;
+        }
+        char spec[32];
+        memcpy(spec, spec_begin, p - spec_begin);
+        spec[p - spec_begin] = '\0';
+        char *out = varname + pos;
+        int room = 1000 - pos;
+        const VarnameArg& arg = varname_args[k];
+        int n = 0;
+        switch(varname_types[k++]) {
+          case VARARG_INT: n = snprintf(out, room, spec, arg.i); break;
+          case VARARG_UINT: n = snprintf(out, room, spec, arg.u); break;
+          case VARARG_LONG: n = snprintf(out, room, spec, arg.l); break;
+          case VARARG_ULONG: n = snprintf(out, room, spec, arg.ul); break;
+          case VARARG_LLONG: n = snprintf(out, room, spec, arg.ll); break;
+          case VARARG_ULLONG: n = snprintf(out, room, spec, arg.ull); break;
+          case VARARG_SIZE: n = snprintf(out, room, spec, arg.z); break;
+          case VARARG_PTRDIFF: n = snprintf(out, room, spec, arg.t); break;
+          case VARARG_PTR: n = snprintf(out, room, spec, arg.p); break;
+          case VARARG_WINT: n = snprintf(out, room, spec, arg.wc); break;
+        }
+        if(n > 0) pos += std::min(n, 999 - pos);
+      }
+      varname[pos] = '\0';
+    }
+    IntData readInt(const char *format = "<?>", ...) ATTR_PRINTF(2,3) {
+      va_list ap;
+      va_start(ap, format);
+      setVarnameV(format, ap);
+      va_end(ap);
+      CHECKERLIB_COUNT(ParseTimer timer(stats, stats.ints, 1));
+
+      int i;
+      int c;
+      parseInteger(i, c);
+      return IntData(*this, c, i);
+    }
+
+    LongData readLong(const char *format = "<?>", ...) ATTR_PRINTF(2,3) {
+      va_list ap;
+      va_start(ap, format);
+      setVarnameV(format, ap);
+      va_end(ap);
+      CHECKERLIB_COUNT(ParseTimer timer(stats, stats.longs, 1));
+
+      long long i;
+      int c;
+      parseInteger(i, c);
+      return LongData(*this, c, i);
+    }
+
+    // Reads a real number in fixed-point notation ("-12.345") with at
+    // most max_decimals digits after the decimal point.
+    DoubleData readDouble(int max_decimals, const char *format = "<?>", ...) ATTR_PRINTF(3,4) {
+      va_list ap;
+      va_start(ap, format);
+      setVarnameV(format, ap);
+      va_end(ap);
+      CHECKERLIB_COUNT(ParseTimer timer(stats, stats.doubles, 1));
+
+      double d;
+      int c;
+      parseReal(max_decimals, false, d, c);
+      return DoubleData(*this, c, d);
+    }
+
+    // Reads a real number of any precision, exponent notation allowed.
+    DoubleData readReal(const char *format = "<?>", ...) ATTR_PRINTF(2,3) {
+      va_list ap;
+      va_start(ap, format);
+      setVarnameV(format, ap);
+      va_end(ap);
+      CHECKERLIB_COUNT(ParseTimer timer(stats, stats.doubles, 1));
+
+      double d;
+      int c;
+      parseReal(-1, true, d, c);
+      return DoubleData(*this, c, d);
+    }
+
+    // The string readers return views into the reader (see StringView):
+    // they stay valid until the next read, so call str() to keep them.
+
+    // Reads a non-empty run of non-whitespace characters.
+    StringData readToken(const char *format = "<?>", ...) ATTR_PRINTF(2,3) {
+      va_list ap;
+      va_start(ap, format);
+      setVarnameV(format, ap);
+      va_end(ap);
+      CHECKERLIB_COUNT(ParseTimer timer(stats, stats.strings, 1));
+
+      StringView s = readSpan(tokenCharset());
+      if(s.empty()) {
+        abortReadingWithError("error reading token: empty token");
+      }
+      int c = readChar();
+      return StringData(*this, c, s);
+    }
+
+    // Reads a token of min_len..max_len characters, all in charset.  If
+    // charset contains spaces, they are part of the string.
+    StringData readString(size_t min_len, size_t max_len, const Charset& charset,
+        const char *format = "<?>", ...) ATTR_PRINTF(5,6) {
+      va_list ap;
+      va_start(ap, format);
+      setVarnameV(format, ap);
+      va_end(ap);
+      CHECKERLIB_COUNT(ParseTimer timer(stats, stats.strings, 1));
+
+      StringView s = readChecked(min_len, max_len, charset, isSpace);
+      int c = readChar();
+      return StringData(*this, c, s);
+    }
+
+    // Reads the rest of the line, without the newline.  The newline is
+    // the delimiter; it is missing (EOF) if the input ends first.
+    StringData readLine(const char *format = "<?>", ...) ATTR_PRINTF(2,3) {
+      va_list ap;
+      va_start(ap, format);
+      setVarnameV(format, ap);
+      va_end(ap);
+      CHECKERLIB_COUNT(ParseTimer timer(stats, stats.strings, 1));
+
+      StringView s = readSpan(lineCharset());
+      int c = readChar();
+      return StringData(*this, c, s);
+    }
+
+    // Reads the rest of the line, which must have min_len..max_len
+    // characters, all in charset.
+    StringData readLine(size_t min_len, size_t max_len, const Charset& charset,
+        const char *format = "<?>", ...) ATTR_PRINTF(5,6) {
+      va_list ap;
+      va_start(ap, format);
+      setVarnameV(format, ap);
+      va_end(ap);
+      CHECKERLIB_COUNT(ParseTimer timer(stats, stats.strings, 1));
+
+      StringView s = readChecked(min_len, max_len, charset, isNewline);
+      int c = readChar();
+      return StringData(*this, c, s);
+    }
+
+    // Layouts understood by the bulk readers below.
+    enum ArrayLayout {
+      ROW,    // x[0] x[1] ... x[n-1] on one line
+      COLUMN  // one element per line
+    };
+
+    // Equivalent to reading name[i] with readInt(...).range(min_val,max_val)
+    // followed by ary(i,n) (ROW) or eol() (COLUMN), for i = 0, ..., n-1.
+    void readInts(int *out, int n, int min_val, int max_val, ArrayLayout layout, const char *name = "<?>") {
+      readArray(out, n, min_val, max_val, layout == ROW ? ' ' : '\n', name);
+    }
+    void readInts(std::vector<int>& out, int n, int min_val, int max_val, ArrayLayout layout, const char *name = "<?>") {
+      out.resize(n);
+      readArray(out.empty() ? NULL : &out[0], n, min_val, max_val, layout == ROW ? ' ' : '\n', name);
+    }
+    void readLongs(long long *out, int n, long long min_val, long long max_val, ArrayLayout layout, const char *name = "<?>") {
+      readArray(out, n, min_val, max_val, layout == ROW ? ' ' : '\n', name);
+    }
+    void readLongs(std::vector<long long>& out, int n, long long min_val, long long max_val, ArrayLayout layout, const char *name = "<?>") {
+      out.resize(n);
+      readArray(out.empty() ? NULL : &out[0], n, min_val, max_val, layout == ROW ? ' ' : '\n', name);
+    }
+
+    // Reads n lines of the form "xs[i] ys[i]", both within [min_val,max_val].
+    void readIntPairs(int *xs, int *ys, int n, int min_val, int max_val, const char *xname = "<?>", const char *yname = "<?>") {
+      readPairs(xs, ys, n, min_val, max_val, xname, yname);
+    }
+    void readIntPairs(std::vector<int>& xs, std::vector<int>& ys, int n, int min_val, int max_val, const char *xname = "<?>", const char *yname = "<?>") {
+      xs.resize(n);
+      ys.resize(n);
+      readPairs(xs.empty() ? NULL : &xs[0], ys.empty() ? NULL : &ys[0], n, min_val, max_val, xname, yname);
+    }
+    void readLongPairs(long long *xs, long long *ys, int n, long long min_val, long long max_val, const char *xname = "<?>", const char *yname = "<?>") {
+      readPairs(xs, ys, n, min_val, max_val, xname, yname);
+    }
+    void readLongPairs(std::vector<long long>& xs, std::vector<long long>& ys, int n, long long min_val, long long max_val, const char *xname = "<?>", const char *yname = "<?>") {
+      xs.resize(n);
+      ys.resize(n);
+      readPairs(xs.empty() ? NULL : &xs[0], ys.empty() ? NULL : &ys[0], n, min_val, max_val, xname, yname);
+    }
+
+    void readEof() {
+      const int c = readChar();
+      syncIODump();
+      if(c != -1) {
+        internal_fd = -1;
+        abortReadingWithError("error reading EOF: not an EOF");
+      }
+      int fd = internal_fd;
+      internal_fd = -1;
+      closed_fd = fd;
+      CHECKERLIB_COUNT(if(!stats_deferred) reportCounters());
+      if(close(fd) < 0) {
+        throw std::runtime_error(std::string("error reading file: ")+detail::errorString(errno));
+      }
+    }
+
+#ifdef CHECKERLIB_COUNTERS
+    const Counters& counters() const {
+      return stats;
+    }
+#endif
+
+    // Lets the one-record-per-line bulk readers (COLUMN layout and the
+    // pair readers) parse a mapped input file with this many threads;
+    // 0 means one per online processor.  Results and errors are the same
+    // as with sequential reading.  Ignored while IODump is enabled.
+    void enableParallelReading(int threads = 0) {
+      if(threads < 0) throw std::invalid_argument("Reader::enableParallelReading(int): threads is negative");
+      parallel_threads = threads ? threads : detail::onlineProcessors();
+    }
+
+    void enableIODump() {
+      if(dump_stream < 0) {
+        int line, col;
+        currentPosition(line, col);
+        dump_stream = detail::DumpLog::instance().openStream(
+            detail::DumpLog::STREAM_IN, filename, line, pos_pending);
+        dump_from = cur;
+      }
+    }
+  };
+
+#ifdef CHECKERLIB_CXX11
+  ////
+  //// Input Schemas (C++11)
+  ////
+
+  // A format described by types instead of a chain of reads.  Input<...>
+  // instantiates into a single-pass parser with the range and delimiter
+  // checks fused into each token, as the bulk readers do, and reports
+  // errors through the same position descriptions as readInt().
+  //
+  //   // N M / A_1 ... A_N / M lines "l r" with 1 <= l <= r <= N
+  //   using namespace checker::schema;
+  //   typedef Input<
+  //     Line<Int<Const<1>, Const<200000>>, Int<Const<0>, Const<200000>>>,
+  //     Line<Array<Var<0>, Int<Const<1>, Const<1000000000>>>>,
+  //     Lines<Var<1>, Line<Int<Const<1>, Var<0>>, Int<Var<2>, Var<0>>>>
+  //   > Format;
+  //   Format::Values v = Format::read(in, "N M A l r");
+  //
+  // Every Int or Long gets a slot, numbered in the order of the schema;
+  // Var<i> is the value of slot i, which must come earlier.  The slots
+  // of a repeated line hold its current row, and the last row once read
+  // returns the values.  Names are given one word per Int, Long or Array.
+  namespace schema {
+    // Bounds and counts.
+    template<long long V>
+    struct Const {
+      static constexpr bool before(int) { return true; }
+      static constexpr bool within(long long lo, long long hi) { return lo <= V && V <= hi; }
+      static constexpr long long get(const long long *) { return V; }
+    };
+    template<int I>
+    struct Var {
+      static constexpr bool before(int slot) { return 0 <= I && I < slot; }
+      static constexpr bool within(long long, long long) { return true; }
+      static long long get(const long long *vals) { return vals[I]; }
+    };
+
+    struct Context {
+      Reader& in;
+      long long *vals;
+      const char *names;
+      int row;  // of the innermost Lines (-1: none)
+      int last_field, last_row, last_idx;
+      Context(Reader& in, long long *vals, const char *names)
+        : in(in), vals(vals), names(names), row(-1),
+          last_field(-1), last_row(-1), last_idx(-1) {}
+    };
+
+    struct Access {
+      // The variable name is only materialized when a check fails.
+      static void setName(Context& ctx, int field, int row, int idx) {
+        Reader& in = ctx.in;
+        const char *p = ctx.names;
+        for(int k = 0; *p && k <= field; k++) {
+          while(*p == ' ') p++;
+          if(k == field) break;
+          while(*p && *p != ' ') p++;
+        }
+        size_t len = strcspn(p, " ");
+        if(field < 0 || len == 0) {
+          p = "<?>";
+          len = 3;
+        }
+        len = std::min<size_t>(len, 1000 - 2 * (ITOS_BUFFER_SIZE + 2));
+        memcpy(in.varname, p, len);
+        in.varname[len] = '\0';
+        char buf[ITOS_BUFFER_SIZE];
+        if(row >= 0) {
+          strcat(in.varname, "[");
+          strcat(in.varname, itos(row, buf));
+          strcat(in.varname, "]");
+        }
+        if(idx >= 0) {
+          strcat(in.varname, "[");
+          strcat(in.varname, itos(idx, buf));
+          strcat(in.varname, "]");
+        }
+        in.varname_format = NULL;
+      }
+      static void fail(Context& ctx, int field, int idx, const char *msg) ATTR_NORETURN {
+        setName(ctx, field, ctx.row, idx);
+        ctx.in.abortReadingWithError(msg);
+      }
+      template<typename T>
+      static T token(Context& ctx, int& c, int field, int idx) {
+        T val;
+        CHECKERLIB_COUNT(ctx.in.tokenCount(&val)++);
+        if(!ctx.in.parseIntegerFast(val, c)) {
+          setName(ctx, field, ctx.row, idx);
+          ctx.in.parseInteger(val, c);
+        }
+        return val;
+      }
+      static void delimiter(Context& ctx, int c, bool more, int field, int idx) {
+        if(c != (more ? ' ' : '\n')) {
+          fail(ctx, field, idx, more ? "delimiter SPC is expected" : "delimiter EOL is expected");
+        }
+        ctx.last_field = field;
+        ctx.last_row = ctx.row;
+        ctx.last_idx = idx;
+      }
+      static void emptyLine(Context& ctx, int field) {
+        if(ctx.in.readChar() != '\n') fail(ctx, field, -1, "delimiter EOL is expected");
+      }
+      template<typename Format>
+      static void read(Context& ctx) {
+        {
+          CHECKERLIB_COUNT(Reader::ParseTimer timer(ctx.in.stats, ctx.in.stats.ints, 0));
+          Format::template parse<0, 0>(ctx);
+        }
+        setName(ctx, ctx.last_field, ctx.last_row, ctx.last_idx);
+        ctx.in.readEof();
+      }
+    };
+
+    // Fields of a line: single values and arrays.
+    template<typename T, typename Lo, typename Hi>
+    struct Scalar {
+      typedef T value_type;
+      typedef Lo lower;
+      typedef Hi upper;
+      static constexpr int slots = 1;
+      static constexpr int fields = 1;
+      static bool nonEmpty(const long long *) { return true; }
+      // Rest: the fields after this one on its line.
+      template<int Slot, int Field, typename Rest>
+      static void parse(Context& ctx) {
+        static_assert(Lo::before(Slot) && Hi::before(Slot), "schema: a bound refers to a later value");
+        int c;
+        const T val = Access::token<T>(ctx, c, Field, -1);
+        ctx.vals[Slot] = val;
+        if(!(Lo::get(ctx.vals) <= val && val <= Hi::get(ctx.vals))) {
+          Access::fail(ctx, Field, -1, "invalid range");
+        }
+        Access::delimiter(ctx, c, Rest::nonEmpty(ctx.vals), Field, -1);
+      }
+    };
+    template<typename Lo, typename Hi>
+    struct Int : Scalar<int, Lo, Hi> {
+      static_assert(Lo::within(INT_MIN, INT_MAX) && Hi::within(INT_MIN, INT_MAX), "schema: Int bound out of range");
+    };
+    template<typename Lo, typename Hi>
+    struct Long : Scalar<long long, Lo, Hi> {};
+
+    // Count values on one line, separated by spaces.
+    template<typename Count, typename Elem>
+    struct Array {
+      static constexpr int slots = 0;
+      static constexpr int fields = 1;
+      static bool nonEmpty(const long long *vals) { return Count::get(vals) > 0; }
+      template<int Slot, int Field, typename Rest>
+      static void parse(Context& ctx) {
+        typedef typename Elem::value_type T;
+        typedef typename Elem::lower Lo;
+        typedef typename Elem::upper Hi;
+        static_assert(Count::before(Slot) && Lo::before(Slot) && Hi::before(Slot), "schema: a count or bound refers to a later value");
+        const long long n = Count::get(ctx.vals);
+        if(n < 0 || n > INT_MAX) throw std::domain_error("schema::Array: count is out of range");
+        const long long lo = Lo::get(ctx.vals), hi = Hi::get(ctx.vals);
+        for(int i = 0; i < n; i++) {
+          int c;
+          const T val = Access::token<T>(ctx, c, Field, i);
+          if(!(lo <= val && val <= hi)) Access::fail(ctx, Field, i, "invalid range");
+          if(i+1 < n) {
+            if(c != ' ') Access::fail(ctx, Field, i, "delimiter SPC is expected");
+          } else {
+            Access::delimiter(ctx, c, Rest::nonEmpty(ctx.vals), Field, i);
+          }
+        }
+      }
+    };
+
+    template<typename... Fs>
+    struct Fields;
+    template<>
+    struct Fields<> {
+      static constexpr int slots = 0;
+      static constexpr int fields = 0;
+      static bool nonEmpty(const long long *) { return false; }
+      template<int Slot, int Field>
+      static void parse(Context&) {}
+    };
+    template<typename F, typename... Rest>
+    struct Fields<F, Rest...> {
+      static constexpr int slots = F::slots + Fields<Rest...>::slots;
+      static constexpr int fields = F::fields + Fields<Rest...>::fields;
+      static bool nonEmpty(const long long *vals) {
+        return F::nonEmpty(vals) || Fields<Rest...>::nonEmpty(vals);
+      }
+      template<int Slot, int Field>
+      static void parse(Context& ctx) {
+        F::template parse<Slot, Field, Fields<Rest...> >(ctx);
+        Fields<Rest...>::template parse<Slot + F::slots, Field + F::fields>(ctx);
+      }
+    };
+
+    // Lines of the input.
+    template<typename... Fs>
+    struct Line {
+      static constexpr int slots = Fields<Fs...>::slots;
+      static constexpr int fields = Fields<Fs...>::fields;
+      template<int Slot, int Field>
+      static void parse(Context& ctx) {
+        if(!Fields<Fs...>::nonEmpty(ctx.vals)) {
+          Access::emptyLine(ctx, Field);
+        } else {
+          Fields<Fs...>::template parse<Slot, Field>(ctx);
+        }
+      }
+    };
+    // Count lines of the same form; their names are indexed by row.
+    template<typename Count, typename L>
+    struct Lines {
+      static constexpr int slots = L::slots;
+      static constexpr int fields = L::fields;
+      template<int Slot, int Field>
+      static void parse(Context& ctx) {
+        static_assert(Count::before(Slot), "schema: a count refers to a later value");
+        const long long n = Count::get(ctx.vals);
+        if(n < 0 || n > INT_MAX) throw std::domain_error("schema::Lines: count is out of range");
+        const int outer = ctx.row;
+        for(int i = 0; i < n; i++) {
+          ctx.row = i;
+          L::template parse<Slot, Field>(ctx);
+        }
+        ctx.row = outer;
+      }
+    };
+
+    // A whole input: its lines, then EOF.
+    template<typename... Ls>
+    struct Input {
+      static constexpr int slots = Fields<Ls...>::slots;
+      static constexpr int fields = Fields<Ls...>::fields;
+      typedef std::array<long long, slots> Values;
+      template<int Slot, int Field>
+      static void parse(Context& ctx) {
+        Parts<Slot, Field, Ls...>::parse(ctx);
+      }
+      template<int Slot, int Field, typename... Rest>
+      struct Parts {
+        static void parse(Context&) {}
+      };
+      template<int Slot, int Field, typename L, typename... Rest>
+      struct Parts<Slot, Field, L, Rest...> {
+        static void parse(Context& ctx) {
+          L::template parse<Slot, Field>(ctx);
+          Parts<Slot + L::slots, Field + L::fields, Rest...>::parse(ctx);
+        }
+      };
+      // names: one word per Int, Long or Array, separated by spaces.
+      static Values read(Reader& in, const char *names = "") {
+        Values vals;
+        vals.fill(0);
+        Context ctx(in, vals.data(), names);
+        Access::read<Input>(ctx);
+        return vals;
+      }
+    };
+  }
+#endif
+
+  ////
+  //// Tools for Input Validation
+  ////
+
+  // Runs an input validator over many files in one process.  The
+  // validator is a function or functor called as func(reader) with a
+  // Reader opened on one file; it is called from several threads at once,
+  // so it must not share unsynchronised state.  Input left unread when it
+  // returns must be at EOF, as if it had called readEof() itself.
+  //
+  //   int main(int argc, char *argv[]) {
+  //     std::vector<BatchValidator::Result> results =
+  //       BatchValidator().addPaths(argv+1).run(validate);
+  //     return BatchValidator::printSummary(results) ? 1 : 0;
+  //   }
+  class BatchValidator : private Uncopyable {
+  public:
+    struct Result {
+      std::string file;
+      bool ok;
+      std::string message;  // the error, if not ok
+      double time;          // wall time in seconds
+    };
+  private:
+    int threads;
+    std::vector<std::string> files;
+    template<typename F>
+    struct Worker {
+      BatchValidator *validator;
+      F *func;
+      std::vector<Result> *results;
+      int *next;
+      pthread_mutex_t *mutex;
+    };
+    template<typename F>
+    static void validate(F& func, const std::string& file, Result& result) {
+      const long long start = Reader::monotonicNanos();
+      result.file = file;
+      result.ok = false;
+      try {
+        Reader in(file.c_str());
+        const int fd = in.internal_fd;
+        try {
+          func(in);
+          if(in.internal_fd >= 0) in.readEof();
+          result.ok = true;
+        } catch(const std::exception& err) {
+          result.message = err.what();
+        } catch(...) {
+          result.message = "unknown exception";
+        }
+        if(in.internal_fd >= 0) in.abortReading();
+        if(in.closed_fd != fd) close(fd);
+      } catch(const std::exception& err) {
+        result.message = err.what();
+      }
+      result.time = (Reader::monotonicNanos() - start) * 1e-9;
+    }
+    template<typename F>
+    static void *workerMain(void *arg) {
+      Worker<F>& worker = *static_cast<Worker<F> *>(arg);
+      for(;;) {
+        pthread_mutex_lock(worker.mutex);
+        const int i = (*worker.next)++;
+        pthread_mutex_unlock(worker.mutex);
+        if(i >= (int)worker.results->size()) return NULL;
+        validate(*worker.func, worker.validator->files[i], (*worker.results)[i]);
+      }
+    }
+  public:
+    // threads = 0 means one per online processor.
+    BatchValidator(int threads = 0)
+      : threads(threads > 0 ? threads : detail::onlineProcessors()) {}
+
+    BatchValidator& addFile(const char *path) {
+      files.push_back(path);
+      return *this;
+    }
+    // Adds the regular files in dir whose names end with suffix, in name
+    // order; hidden files are skipped.
+    BatchValidator& addDirectory(const char *dir, const char *suffix = "") {
+      DIR *dp = opendir(dir);
+      if(!dp) {
+        throw std::runtime_error(std::string("error opening directory ")+dir+": "+detail::errorString(errno));
+      }
+      const size_t suffix_len = strlen(suffix);
+      std::vector<std::string> found;
+      while(struct dirent *ent = readdir(dp)) {
+        const size_t len = strlen(ent->d_name);
+        if(ent->d_name[0] == '.' || len < suffix_len) continue;
+        if(strcmp(ent->d_name + len - suffix_len, suffix) != 0) continue;
+        std::string path = std::string(dir) + "/" + ent->d_name;
+        struct stat st;
+        if(stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+          found.push_back(path);
+        }
+      }
+      closedir(dp);
+      std::sort(found.begin(), found.end());
+      files.insert(files.end(), found.begin(), found.end());
+      return *this;
+    }
+    // Adds each path of a NULL-terminated list (such as argv+1): the files
+    // of a directory, or the path itself otherwise.
+    BatchValidator& addPaths(char **paths) {
+      for(int i = 0; paths[i]; i++) {
+        struct stat st;
+        if(stat(paths[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+          addDirectory(paths[i]);
+        } else {
+          addFile(paths[i]);
+        }
+      }
+      return *this;
+    }
+
+    // Validates every file added so far; results are in the same order.
+    template<typename F>
+    std::vector<Result> run(F func) {
+      std::vector<Result> results(files.size());
+      const int n = std::max(1, std::min(threads, (int)files.size()));
+      int next = 0;
+      pthread_mutex_t mutex;
+      pthread_mutex_init(&mutex, NULL);
+      std::vector<Worker<F> > tasks(n);
+      for(int i = 0; i < n; i++) {
+        tasks[i].validator = this;
+        tasks[i].func = &func;
+        tasks[i].results = &results;
+        tasks[i].next = &next;
+        tasks[i].mutex = &mutex;
+      }
+      detail::runParallel(&tasks[0], n, workerMain<F>);
+      pthread_mutex_destroy(&mutex);
+      return results;
+    }
+    // Prints every failure and a one-line total; returns the number of
+    // failures.
+    static int printSummary(const std::vector<Result>& results, FILE *fp = stdout) {
+      int failed = 0;
+      double time = 0.0;
+      for(size_t i = 0; i < results.size(); i++) {
+        time += results[i].time;
+        if(results[i].ok) continue;
+        failed++;
+        fprintf(fp, "%s: %s\n", results[i].file.c_str(), results[i].message.c_str());
+      }
+      fprintf(fp, "%d file(s): %d passed, %d failed (%.3f s)\n",
+          (int)results.size(), (int)results.size() - failed, failed, time);
+      return failed;
+    }
+  };
+
+  ////
+  //// Tools for Reactive
+  ////
+  class Process : public Reader {
+    static const int WRITE_BUFFER_SIZE = 1 << 16;
+    const char *arg0;
+    std::vector<const char *> args;
+    char *procname;
+    // Output is staged in write_buf and handed to the pipe with write(2)
+    // on flush() or when the buffer fills up.
+    int write_fd;
+    char *write_buf;
+    int write_len;
+    FILE *read_file;
+    int read_fd;
+    pid_t pid;
+#ifdef CHECKERLIB_CXX17
+    // exceptions in flight when the Process was created; more of them in
+    // the destructor mean it is destroyed by stack unwinding.
+    int uncaught;
+#endif
+    int out_stream;
+    int parent_cpu, child_cpu;
+    long long cpu_limit_ms, memory_limit, address_space_limit, output_limit;
+    long long start_ns;
+  public:
+    // Resource usage of the last process, filled in when it is reaped.
+    struct Usage {
+      double user_time, sys_time;     // CPU time in seconds
+      double wall_time;               // from execute() until reaped
+      double wait_time;               // spent blocked on its output
+      long max_rss;                   // in kilobytes
+      long voluntary_switches, involuntary_switches;
+      bool killed;                    // did not exit within the grace period
+    };
+  private:
+    Usage last_usage;
+    void init() {
+      arg0 = NULL;
+      args.clear();
+      procname = NULL;
+      write_fd = -1;
+      write_buf = NULL;
+      write_len = 0;
+      read_file = NULL;
+      read_fd = -1;
+      pid = 0;
+      out_stream = -1;
+      parent_cpu = child_cpu = -1;
+      cpu_limit_ms = memory_limit = address_space_limit = output_limit = -1;
+      start_ns = 0;
+      memset(&last_usage, 0, sizeof(last_usage));
+    }
+    static void applyLimit(int resource, rlim_t soft, rlim_t hard) {
+      struct rlimit rl;
+      rl.rlim_cur = soft;
+      rl.rlim_max = hard;
+      setrlimit(resource, &rl);
+    }
+    // runs in the child between fork and exec.
+    void applyLimits() {
+      if(cpu_limit_ms >= 0) {
+        // RLIMIT_CPU counts whole seconds; the exact limit is checked
+        // against the rusage afterwards.
+        rlim_t sec = (cpu_limit_ms + 999) / 1000 + 1;
+        applyLimit(RLIMIT_CPU, sec, sec + 1);
+      }
+      if(address_space_limit >= 0) applyLimit(RLIMIT_AS, address_space_limit, address_space_limit);
+      if(output_limit >= 0) applyLimit(RLIMIT_FSIZE, output_limit, output_limit);
+    }
+    // reaps the process, records its usage and returns its wait status.
+    // With grace_ms >= 0, the process is killed if it has not exited by
+    // then.
+    int reap(int grace_ms = -1) {
+      int status = 0;
+      struct rusage ru;
+      memset(&ru, 0, sizeof(ru));
+      bool reaped = false;
+      last_usage.killed = false;
+      if(grace_ms >= 0) {
+        const long long deadline = monotonicNanos() + grace_ms * 1000000LL;
+        for(;;) {
+          pid_t ret = wait4(pid, &status, WNOHANG | WUNTRACED, &ru);
+          if(ret == pid) {
+            reaped = true;
+            break;
+          }
+          if(ret < 0 && errno != EINTR) break;
+          if(monotonicNanos() >= deadline) {
+            kill(pid, SIGKILL);
+            last_usage.killed = true;
+            break;
+          }
+          struct timespec ts = { 0, 1000000 };
+          nanosleep(&ts, NULL);
+        }
+      }
+      while(!reaped && wait4(pid, &status, WUNTRACED, &ru) < 0 && errno == EINTR) {}
+      last_usage.user_time = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6;
+      last_usage.sys_time = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+      last_usage.wall_time = (monotonicNanos() - start_ns) * 1e-9;
+      last_usage.wait_time = read_wait_ns * 1e-9;
+      last_usage.max_rss = ru.ru_maxrss;
+      last_usage.voluntary_switches = ru.ru_nvcsw;
+      last_usage.involuntary_switches = ru.ru_nivcsw;
+      return status;
+    }
+    // creates a pipe that is not inherited by other processes started
+    // concurrently (by a ProcessPool, for example).
+    static int makePipe(int fds[2]) {
+#ifdef __linux__
+      return pipe2(fds, O_CLOEXEC);
+#else
+      if(pipe(fds) < 0) return -1;
+      fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+      fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+      return 0;
+#endif
+    }
+    static void pinToCpu(int cpu) {
+#ifdef __linux__
+      if(cpu < 0) return;
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      sched_setaffinity(0, sizeof(set), &set);
+#else
+      (void)cpu;
+#endif
+    }
+    // writes [data,data+len) to the pipe; returns false if it is broken.
+    bool writeRaw(const char *data, size_t len) {
+      CHECKERLIB_COUNT(if(len > 0) stats.flushes++);
+      while(len > 0) {
+        ssize_t n = write(write_fd, data, len);
+        if(n < 0) {
+          if(errno == EINTR) continue;
+          return false;
+        }
+        CHECKERLIB_COUNT(stats.bytes_written += n);
+        data += n;
+        len -= n;
+      }
+      return true;
+    }
+    int append(const char *data, int len) {
+      if(write_len + len > WRITE_BUFFER_SIZE) {
+        if(flush() != 0) return -1;
+        if(len > WRITE_BUFFER_SIZE) return writeRaw(data, len) ? len : -1;
+      }
+      memcpy(write_buf + write_len, data, len);
+      write_len += len;
+      return len;
+    }
+    // returns room for len more bytes at the end of the write buffer.
+    char *reserve(int len) {
+      logConsumed();
+      if(write_len + len > WRITE_BUFFER_SIZE) flush();
+      return write_buf + write_len;
+    }
+    // takes the bytes from the end of the write buffer up to p.
+    void commit(char *p) {
+      if(out_stream >= 0) {
+        logOutput(write_buf + write_len, p - (write_buf + write_len));
+      }
+      write_len = p - write_buf;
+    }
+    void logOutput(const char *data, size_t len) {
+      CHECKERLIB_COUNT(const long long dump_start = detail::counterNanos());
+      detail::DumpLog::instance().data(out_stream, data, len);
+      CHECKERLIB_COUNT(stats.dump_ns += detail::counterNanos() - dump_start);
+    }
+    template<typename T>
+    Process& writeArray(const T *vals, int n, char sep) {
+      if(n < 0) throw std::invalid_argument("Process::writeArray: n is negative");
+      for(int i = 0; i < n; i++) {
+        char *p = reserve(LTOS_BUFFER_SIZE);
+        p = std::copy(detail::formatDecimal(p + LTOS_BUFFER_SIZE, vals[i]), p + LTOS_BUFFER_SIZE, p);
+        *p++ = i+1 < n ? sep : '\n';
+        commit(p);
+      }
+      if(n == 0) writeLine();
+      return *this;
+    }
+  public:
+    void execute() {
+      if(pid) throw std::domain_error("Process::execute(): already executed.");
+      if(args.empty()) throw std::domain_error("Process::execute(): args is empty");
+      const char *file = arg0 ? arg0 : args[0];
+      int pid;
+      int pipe_c2p[2] = { -1, -1 }, pipe_p2c[2] = { -1, -1 }, pipe_status[2];
+      std::vector<const char *> argv(args);
+      argv.push_back(NULL);
+
+      signal(SIGPIPE, SIG_IGN);
+      if (makePipe(pipe_c2p) < 0 || makePipe(pipe_p2c) < 0 || makePipe(pipe_status) < 0) {
+        const int err = errno;
+        for (int k = 0; k < 2; k++) {
+          if (pipe_c2p[k] >= 0) close(pipe_c2p[k]);
+          if (pipe_p2c[k] >= 0) close(pipe_p2c[k]);
+        }
+        throw std::runtime_error(std::string("error creating pipe: ")+detail::errorString(err));
+      }
+      // The child borrows our memory until it execs (vfork), so no page
+      // tables are copied however large the checker is.  It makes only
+      // system calls, with signals blocked so that none of our handlers
+      // runs in it.  All pipes are close-on-exec: the dup2'ed ends are
+      // the only ones the program inherits, and pipe_status reads EOF on
+      // a successful exec, or the errno of a failed one.
+      sigset_t all_signals, saved_mask;
+      sigfillset(&all_signals);
+      pthread_sigmask(SIG_SETMASK, &all_signals, &saved_mask);
+      pid = vfork();
+      if (pid == 0) {
         dup2(pipe_p2c[0], 0); dup2(pipe_c2p[1], 1);
-        close(pipe_p2c[0]); close(pipe_c2p[1]);
+        pinToCpu(child_cpu);
+        applyLimits();
+        pthread_sigmask(SIG_SETMASK, &saved_mask, NULL);
+
+        execvp(file, (char * const *)&argv[0]);
+        int err = errno;
+        while (write(pipe_status[1], &err, sizeof(err)) < 0 && errno == EINTR) {}
+        _exit(127);
+      }
+      const int fork_errno = errno;
+      pthread_sigmask(SIG_SETMASK, &saved_mask, NULL);
+      close(pipe_p2c[0]); close(pipe_c2p[1]); close(pipe_status[1]);
+      int exec_errno = 0;
+      ssize_t status_len = 0;
+      if (pid > 0) {
+        while ((status_len = read(pipe_status[0], &exec_errno, sizeof(exec_errno))) < 0 && errno == EINTR) {}
+      }
+      close(pipe_status[0]);
+      if (pid < 0 || status_len > 0) {
+        close(pipe_c2p[0]); close(pipe_p2c[1]);
+        if (pid < 0) {
+          throw std::runtime_error(std::string("error forking process: ")+detail::errorString(fork_errno));
+        }
+        while (waitpid(pid, NULL, 0) < 0 && errno == EINTR) {}
+        throw std::runtime_error(std::string("error executing process ")+file+": "+detail::errorString(exec_errno));
+      }
+      pinToCpu(parent_cpu);
+      if(!write_buf) write_buf = new char[WRITE_BUFFER_SIZE];
+      delete[] this->procname;
+      this->procname = new char[strlen(file)+1];
+      this->read_fd = pipe_c2p[0];
+      this->write_fd = pipe_p2c[1];
+      this->write_len = 0;
+      this->pid = pid;
+      this->arg0 = NULL;
+      this->args.clear();
+      this->read_timed_out = false;
+      this->read_wait_ns = 0;
+      this->start_ns = monotonicNanos();
+      CHECKERLIB_COUNT(this->stats_deferred = true);
+      strcpy(this->procname, file);
+      if(out_stream >= 0) {
+        detail::DumpLog::instance().rename(out_stream, procname);
+        detail::DumpLog::instance().setLine(out_stream, 1);
+      }
+      open(read_fd, procname);
+    }
+    void closeProcess() {
+      closeProcess(-1);
+    }
+    // Same, but kills the process if it has not exited grace_ms after its
+    // input was closed (negative: wait indefinitely).
+    void closeProcess(int grace_ms) {
+      if(write_fd >= 0) {
+        closeWriting();
+      }
+      dispose();
+      int status = reap(grace_ms);
+      syncIODump();
+      CHECKERLIB_COUNT(reportCounters());
+      read_file = NULL;
+      read_fd = -1;
+      pid = 0;
+      const double cpu_time = last_usage.user_time + last_usage.sys_time;
+      if((cpu_limit_ms >= 0 && cpu_time * 1000 > cpu_limit_ms) ||
+          (WIFSIGNALED(status) && WTERMSIG(status) == SIGXCPU)) {
+        throw TimeLimitExceeded(std::string(procname)+": time limit exceeded");
+      }
+      if(last_usage.killed) {
+        throw TimeLimitExceeded(std::string(procname)+": still running "+itos(grace_ms)+" ms after its input was closed");
+      }
+      if(memory_limit >= 0 && last_usage.max_rss * 1024LL > memory_limit) {
+        throw MemoryLimitExceeded(std::string(procname)+": memory limit exceeded");
+      }
+      if(WIFSIGNALED(status) && WTERMSIG(status) == SIGXFSZ) {
+        throw RuntimeError(std::string(procname)+": output limit exceeded");
+      }
+      if(!WIFEXITED(status)) {
+        throw RuntimeError(std::string(procname)+": exited abnormally");
+      }
+      if(WEXITSTATUS(status) != 0) {
+        throw RuntimeError(std::string(procname)+": exited with status "+itos(WEXITSTATUS(status)));
+      }
+    }
+    Process() {
+      init();
+#ifdef CHECKERLIB_CXX17
+      uncaught = std::uncaught_exceptions();
+#endif
+    }
+    ~Process() CHECKERLIB_THROWING_DTOR {
+#ifdef CHECKERLIB_CXX17
+      const bool unwinding = std::uncaught_exceptions() > uncaught;
+#else
+      const bool unwinding = std::uncaught_exception();
+#endif
+      if(pid && (read_timed_out || unwinding)) {
+        // the child may be stalled, and a verdict could not be thrown
+        // from here anyway; do not wait for it to exit.
+        kill(pid, SIGKILL);
+        if(write_fd >= 0) close(write_fd);
+        reap();
+        pid = 0;
+      }
+      if(pid) {
+        closeProcess();
+      }
+      if(out_stream >= 0) {
+        detail::DumpLog::instance().close(out_stream);
+      }
+      delete[] write_buf;
+      delete[] procname;
+    }
+    bool isRunning() const {
+      return pid != 0;
+    }
+    // Waits up to timeout_ms for the process to exit, without reaping it;
+    // returns whether it did.
+    bool waitExit(int timeout_ms) {
+      if(!pid) return true;
+      const long long deadline = monotonicNanos() + timeout_ms * 1000000LL;
+      for(;;) {
+        siginfo_t info;
+        info.si_pid = 0;
+        if(waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == pid) {
+          return true;
+        }
+        if(monotonicNanos() >= deadline) return false;
+        struct timespec ts = { 0, 1000000 };
+        nanosleep(&ts, NULL);
+      }
+    }
+    void closeWriting() {
+      flush();
+      close(write_fd);
+      write_fd = -1;
+    }
+    // Makes every subsequent read from the process fail with TimeLimitExceeded
+    // if no output arrives within the given time; negative disables it.
+    Process& setReadTimeout(int milliseconds) {
+      read_timeout_ms = milliseconds < 0 ? -1 : milliseconds;
+      return *this;
+    }
+    // Limits for processes started by later execute() calls; negative
+    // removes the limit.  The time limit is in milliseconds of user plus
+    // system time.  The memory limit is checked against the peak resident
+    // set size once the process has exited, while the address space limit
+    // (RLIMIT_AS) makes allocations beyond it fail.  The output limit is
+    // the largest file the process may write.
+    Process& setTimeLimit(long long milliseconds) {
+      cpu_limit_ms = milliseconds < 0 ? -1 : milliseconds;
+      return *this;
+    }
+    Process& setMemoryLimit(long long bytes) {
+      memory_limit = bytes < 0 ? -1 : bytes;
+      return *this;
+    }
+    Process& setAddressSpaceLimit(long long bytes) {
+      address_space_limit = bytes < 0 ? -1 : bytes;
+      return *this;
+    }
+    Process& setOutputLimit(long long bytes) {
+      output_limit = bytes < 0 ? -1 : bytes;
+      return *this;
+    }
+    const Usage& usage() const {
+      return last_usage;
+    }
+    // Pins the checker and the child to the given processors from the next
+    // execute() on (Linux only); -1 leaves that side unpinned.
+    Process& setAffinity(int checker_cpu, int process_cpu) {
+      parent_cpu = checker_cpu;
+      child_cpu = process_cpu;
+      return *this;
+    }
+    // Pins the checker and the child to the first two processors it is
+    // allowed to run on, if there are at least two.
+    Process& setAffinity() {
+#ifdef __linux__
+      cpu_set_t set;
+      if(sched_getaffinity(0, sizeof(set), &set) == 0) {
+        int found[2], nfound = 0;
+        for(int cpu = 0; cpu < CPU_SETSIZE && nfound < 2; cpu++) {
+          if(CPU_ISSET(cpu, &set)) found[nfound++] = cpu;
+        }
+        if(nfound == 2) return setAffinity(found[0], found[1]);
+      }
+#endif
+      return *this;
+    }
+    int vscanf(const char *format, va_list ap) {
+      if(!read_file) {
+        if(cur != end) {
+          throw std::logic_error("Process::vscanf(const char*,va_list): "
+              "input already buffered by the reader; cannot switch to scanf.");
+        }
+        read_file = fdopen(read_fd, "r");
+      }
+      abortReading();
+      return vfscanf(read_file, format, ap);
+    }
+    int vprintf(const char *format, va_list ap) {
+      // input consumed so far is dumped ahead of this output.
+      logConsumed();
+      // formats straight into the buffer; only output that does not fit
+      // is formatted a second time.
+      va_list ap2;
+      CHECKERLIB_VA_COPY(ap2, ap);
+      const int room = WRITE_BUFFER_SIZE - write_len;
+      int len = vsnprintf(write_buf + write_len, room, format, ap);
+      if(len >= 0 && len < room) {
+        if(out_stream >= 0) logOutput(write_buf + write_len, len);
+        write_len += len;
+      } else if(len >= 0) {
+        std::vector<char> tmp(len + 1);
+        vsnprintf(&tmp[0], len + 1, format, ap2);
+        if(out_stream >= 0) logOutput(&tmp[0], len);
+        len = append(&tmp[0], len);
+      }
+      va_end(ap2);
+      return len;
+    }
+    int flush() {
+      int len = write_len;
+      write_len = 0;
+      return writeRaw(write_buf, len) ? 0 : EOF;
+    }
+
+    // Typed output, formatted straight into the write buffer.  Like
+    // printf, nothing reaches the process before flush().
+    Process& writeInt(int val) {
+      return writeLong(val);
+    }
+    Process& writeLong(long long val) {
+      char *p = reserve(LTOS_BUFFER_SIZE);
+      commit(std::copy(detail::formatDecimal(p + LTOS_BUFFER_SIZE, val), p + LTOS_BUFFER_SIZE, p));
+      return *this;
+    }
+    Process& writeChar(char c) {
+      char *p = reserve(1);
+      *p = c;
+      commit(p + 1);
+      return *this;
+    }
+    Process& writeSpace() {
+      return writeChar(' ');
+    }
+    Process& writeLine() {
+      return writeChar('\n');
+    }
+    // Writes n values separated by sep and followed by a newline.
+    Process& writeInts(const int *vals, int n, char sep = ' ') {
+      return writeArray(vals, n, sep);
+    }
+    Process& writeInts(const std::vector<int>& vals, char sep = ' ') {
+      return writeArray(vals.empty() ? NULL : &vals[0], (int)vals.size(), sep);
+    }
+    Process& writeLongs(const long long *vals, int n, char sep = ' ') {
+      return writeArray(vals, n, sep);
+    }
+    Process& writeLongs(const std::vector<long long>& vals, char sep = ' ') {
+      return writeArray(vals.empty() ? NULL : &vals[0], (int)vals.size(), sep);
+    }
+    void enableIODump() {
+      if(out_stream < 0) {
+        out_stream = detail::DumpLog::instance().openStream(
+            detail::DumpLog::STREAM_OUT, procname, 1, -1);
+        Reader::enableIODump();
+      }
+    }
+
+    Process& push(const char *argval) {
+      args.push_back(argval);
+      return *this;
+    }
+    Process& push(const char **argval) {
+      for(int i = 0; argval[i]; i++) {
+        args.push_back(argval[i]);
+      }
+      return *this;
+    }
+    Process& push(char **argval) {
+      for(int i = 0; argval[i]; i++) {
+        args.push_back(argval[i]);
+      }
+      return *this;
+    }
+    Process& setExecFile(const char *argval) {
+      arg0 = argval;
+      return *this;
+    }
+
+    int scanf(const char *format, ...) ATTR_SCANF(2,3) {
+      va_list ap;
+      va_start(ap, format);
+      int ret = vscanf(format, ap);
+      va_end(ap);
+      return ret;
+    }
+    int printf(const char *format, ...) ATTR_PRINTF(2,3) {
+      va_list ap;
+      va_start(ap, format);
+      int ret = vprintf(format, ap);
+      va_end(ap);
+      return ret;
+    }
+  };
+
+  // Judges many tests at once: every test gets its own Process, started
+  // with the arguments and limits configured here, and up to slots of
+  // them run concurrently, one thread per slot.  The interaction is a
+  // function or functor called as func(process, test) (or
+  // func(reader, process, test) with an input file per test); it is
+  // called from several threads at once.  Exceptions it throws become the
+  // verdict of that test; a process that had already failed when a wrong
+  // answer was detected is reported by its own failure instead.
+  class ProcessPool : private Uncopyable {
+  public:
+    enum Verdict {
+      ACCEPTED, WRONG_ANSWER, TIME_LIMIT_EXCEEDED, MEMORY_LIMIT_EXCEEDED,
+      RUNTIME_ERROR, JUDGE_ERROR
+    };
+    struct Result {
+      Verdict verdict;
+      std::string message;
+      Process::Usage usage;
+    };
+    static const char *verdictName(Verdict verdict) {
+      static const char *const names[] = { "AC", "WA", "TLE", "MLE", "RE", "JE" };
+      return names[verdict];
+    }
+  private:
+    static const int EXIT_WAIT_MS = 20;
+    int slots;
+    const char *arg0;
+    std::vector<const char *> args;
+    long long cpu_limit_ms, memory_limit, address_space_limit, output_limit;
+    int read_timeout_ms, grace_ms;
+    template<typename F>
+    struct Slot {
+      ProcessPool *pool;
+      F *func;
+      std::vector<Result> *results;
+      int *next;
+      pthread_mutex_t *mutex;
+    };
+    template<typename F>
+    struct WithInput {
+      const std::vector<std::string> *inputs;
+      F *func;
+      void operator()(Process& p, int test) {
+        Reader in((*inputs)[test].c_str());
+        try {
+          (*func)(in, p, test);
+        } catch(...) {
+          finish(in);
+          throw;
+        }
+        finish(in);
+      }
+    };
+    static void finish(Reader& in) {
+      if(in.internal_fd >= 0) {
+        close(in.internal_fd);
+        in.abortReading();
+      }
+    }
+    static void classify(Result& result, Verdict verdict, const std::exception& err) {
+      result.verdict = verdict;
+      result.message = err.what();
+    }
+    template<typename F>
+    void judge(F& func, int test, Result& result) {
+      Process p;
+      for(size_t i = 0; i < args.size(); i++) {
+        p.push(args[i]);
+      }
+      if(arg0) p.setExecFile(arg0);
+      p.setTimeLimit(cpu_limit_ms).setMemoryLimit(memory_limit);
+      p.setAddressSpaceLimit(address_space_limit).setOutputLimit(output_limit);
+      p.setReadTimeout(read_timeout_ms);
+      result.verdict = ACCEPTED;
+      try {
+        try {
+          p.execute();
+          func(p, test);
+        } catch(const ParseError& err) {
+          classify(result, WRONG_ANSWER, err);
+        }
+        if(p.isRunning()) {
+          // a wrong answer stands unless the process had already failed
+          // (and is merely being noticed through its missing output);
+          // otherwise the process is stopped right away.
+          const bool exited = result.verdict == ACCEPTED || p.waitExit(EXIT_WAIT_MS);
+          finish(p);
+          try {
+            p.closeProcess(exited ? grace_ms : 0);
+          } catch(const ProcessError&) {
+            if(exited) throw;
+          }
+        }
+      } catch(const TimeLimitExceeded& err) {
+        classify(result, TIME_LIMIT_EXCEEDED, err);
+      } catch(const MemoryLimitExceeded& err) {
+        classify(result, MEMORY_LIMIT_EXCEEDED, err);
+      } catch(const ProcessError& err) {
+        classify(result, RUNTIME_ERROR, err);
+      } catch(const std::exception& err) {
+        classify(result, JUDGE_ERROR, err);
+      }
+      if(p.isRunning()) {
+        // the interaction failed for some other reason.
+        finish(p);
+        try {
+          p.closeProcess(0);
+        } catch(const ProcessError&) {
+        }
+      }
+      result.usage = p.usage();
+    }
+    template<typename F>
+    static void *slotMain(void *arg) {
+      Slot<F>& slot = *static_cast<Slot<F> *>(arg);
+      for(;;) {
+        pthread_mutex_lock(slot.mutex);
+        const int test = (*slot.next)++;
+        pthread_mutex_unlock(slot.mutex);
+        if(test >= (int)slot.results->size()) return NULL;
+        slot.pool->judge(*slot.func, test, (*slot.results)[test]);
+      }
+    }
+  public:
+    // slots = 0 means one per online processor.
+    ProcessPool(int slots = 0)
+      : slots(slots > 0 ? slots : detail::onlineProcessors()), arg0(NULL),
+        cpu_limit_ms(-1), memory_limit(-1), address_space_limit(-1), output_limit(-1),
+        read_timeout_ms(-1), grace_ms(1000) {}
+
+    ProcessPool& push(const char *argval) {
+      args.push_back(argval);
+      return *this;
+    }
+    ProcessPool& push(const char **argval) {
+      for(int i = 0; argval[i]; i++) {
+        args.push_back(argval[i]);
+      }
+      return *this;
+    }
+    ProcessPool& push(char **argval) {
+      for(int i = 0; argval[i]; i++) {
+        args.push_back(argval[i]);
+      }
+      return *this;
+    }
+    ProcessPool& setExecFile(const char *argval) {
+      arg0 = argval;
+      return *this;
+    }
+    // See the Process setters of the same names.
+    ProcessPool& setTimeLimit(long long milliseconds) {
+      cpu_limit_ms = milliseconds;
+      return *this;
+    }
+    ProcessPool& setMemoryLimit(long long bytes) {
+      memory_limit = bytes;
+      return *this;
+    }
+    ProcessPool& setAddressSpaceLimit(long long bytes) {
+      address_space_limit = bytes;
+      return *this;
+    }
+    ProcessPool& setOutputLimit(long long bytes) {
+      output_limit = bytes;
+      return *this;
+    }
+    ProcessPool& setReadTimeout(int milliseconds) {
+      read_timeout_ms = milliseconds;
+      return *this;
+    }
+    // How long a process may keep running once the interaction is over
+    // and its input is closed; it is killed afterwards (default 1000 ms).
+    ProcessPool& setGracePeriod(int milliseconds) {
+      grace_ms = milliseconds;
+      return *this;
+    }
+
+    template<typename F>
+    std::vector<Result> run(int tests, F func) {
+      if(tests < 0) throw std::invalid_argument("ProcessPool::run: tests is negative");
+      if(args.empty()) throw std::domain_error("ProcessPool::run: args is empty");
+      std::vector<Result> results(tests);
+      const int n = std::max(1, std::min(slots, tests));
+      int next = 0;
+      pthread_mutex_t mutex;
+      pthread_mutex_init(&mutex, NULL);
+      std::vector<Slot<F> > tasks(n);
+      for(int i = 0; i < n; i++) {
+        tasks[i].pool = this;
+        tasks[i].func = &func;
+        tasks[i].results = &results;
+        tasks[i].next = &next;
+        tasks[i].mutex = &mutex;
+      }
+      detail::runParallel(&tasks[0], n, slotMain<F>);
+      pthread_mutex_destroy(&mutex);
+      return results;
+    }
+    // Runs one test per input file, each with its own Reader.
+    template<typename F>
+    std::vector<Result> run(const std::vector<std::string>& inputs, F func) {
+      WithInput<F> with_input;
+      with_input.inputs = &inputs;
+      with_input.func = &func;
+      return run((int)inputs.size(), with_input);
+    }
+  };
 
-        const char **argv = new const char*[args.size()+1];
-        copy(args.begin(), args.end(), argv);
-        argv[args.size()] = NULL;
+  ////
+  //// Tools for Output Checking
+  ////
 
-        execvp(file, (char * const *)argv);
-        delete[] argv;
-        throw std::runtime_error(std::string("error executing process ")+file+": "+strerror(errno));
+  // Compares an output against the expected one while streaming both,
+  // so memory use does not depend on their size.  EXACT compares the
+  // bytes; TOKENS compares whitespace-separated tokens, ignoring how
+  // much whitespace separates them, optionally case-insensitively and
+  // with a numeric tolerance.  The first difference is thrown as a
+  // ParseError located in the actual output.
+  class Comparator : private Uncopyable {
+  public:
+    enum Mode { EXACT, TOKENS };
+  private:
+    Reader& expected;
+    Reader& actual;
+    Mode mode;
+    bool ignore_case;
+    double abs_eps, rel_eps;
+    // the first bytes of the tokens compared last, when they did not
+    // fit in the buffers; enough for numbers and messages.
+    static const size_t PREFIX_SIZE = 64;
+    std::string expected_prefix, actual_prefix;
+    static void setIndexName(Reader& r, const char *name, long long idx) {
+      snprintf(r.varname, 1000, "%s[%lld]", name, idx);
+      r.varname_format = NULL;
+    }
+    static std::string describeChar(int c) {
+      if(c < 0) return "EOF";
+      char str[8];
+      if(c == '\n') return "'\\n'";
+      if(c == '\t') return "'\\t'";
+      if(c == '\r') return "'\\r'";
+      if(c < 0x20 || c >= 0x7f) {
+        snprintf(str, sizeof(str), "'\\x%02x'", c);
+      } else {
+        snprintf(str, sizeof(str), "'%c'", c);
+      }
+      return str;
+    }
+    static std::string describeToken(const char *tok, size_t len, bool present) {
+      if(!present) return "EOF";
+      if(len > 64) return "'"+std::string(tok, 64)+"...'";
+      return "'"+std::string(tok, len)+"'";
+    }
+    void report(const std::string& str) ATTR_NORETURN {
+      expected.abortReading();
+      actual.abortReadingWithError(str);
+    }
+    // accepts the usual decimal notations only; strtod would also take
+    // hexadecimal, infinities and NaN.
+    static bool parseReal(const char *tok, size_t len, double& val) {
+      char str[64];
+      if(len == 0 || len >= sizeof(str)) return false;
+      memcpy(str, tok, len);
+      str[len] = '\0';
+      const char *p = str;
+      if(*p == '+' || *p == '-') p++;
+      const char *digits = p;
+      while('0' <= *p && *p <= '9') p++;
+      int ndigits = p - digits;
+      if(*p == '.') {
+        digits = ++p;
+        while('0' <= *p && *p <= '9') p++;
+        ndigits += p - digits;
+      }
+      if(ndigits == 0) return false;
+      if(*p == 'e' || *p == 'E') {
+        p++;
+        if(*p == '+' || *p == '-') p++;
+        digits = p;
+        while('0' <= *p && *p <= '9') p++;
+        if(p == digits) return false;
+      }
+      if(p != str + len) return false;
+      val = strtod(str, NULL);
+      return true;
+    }
+    static bool equalIgnoringCase(const char *a, const char *b, size_t len) {
+      for(size_t i = 0; i < len; i++) {
+        char x = a[i], y = b[i];
+        if('A' <= x && x <= 'Z') x += 'a' - 'A';
+        if('A' <= y && y <= 'Z') y += 'a' - 'A';
+        if(x != y) return false;
+      }
+      return true;
+    }
+    bool sameToken(const char *exp, size_t exp_len, const char *act, size_t act_len) const {
+      if(exp_len == act_len &&
+          (ignore_case ? equalIgnoringCase(exp, act, exp_len) : memcmp(exp, act, exp_len) == 0)) {
+        return true;
+      }
+      double x, y;
+      if((abs_eps >= 0 || rel_eps >= 0) && parseReal(exp, exp_len, x) && parseReal(act, act_len, y)) {
+        const double diff = x < y ? y - x : x - y;
+        const double mag = x < 0 ? -x : x;
+        return (abs_eps >= 0 && diff <= abs_eps) || (rel_eps >= 0 && diff <= rel_eps * mag);
+      }
+      return false;
+    }
+    void compareExact() {
+      long long offset = 0;
+      for(;;) {
+        const bool has_exp = expected.cur != expected.end || expected.fill();
+        const bool has_act = actual.cur != actual.end || actual.fill();
+        if(!has_exp || !has_act) {
+          int exp_c = has_exp ? (unsigned char)*expected.cur++ : expected.readEofChar();
+          int act_c = has_act ? (unsigned char)*actual.cur++ : actual.readEofChar();
+          if(exp_c == act_c) break;
+          setIndexName(actual, "byte", offset);
+          report("expected "+describeChar(exp_c)+", found "+describeChar(act_c));
+        }
+        const size_t n = std::min(expected.end - expected.cur, actual.end - actual.cur);
+        if(memcmp(expected.cur, actual.cur, n) != 0) {
+          const size_t k = std::mismatch(expected.cur, expected.cur + n, actual.cur).first - expected.cur;
+          const int exp_c = (unsigned char)expected.cur[k], act_c = (unsigned char)actual.cur[k];
+          expected.cur += k + 1;
+          actual.cur += k + 1;
+          setIndexName(actual, "byte", offset + k);
+          report("expected "+describeChar(exp_c)+", found "+describeChar(act_c));
+        }
+        expected.cur += n;
+        actual.cur += n;
+        offset += n;
+      }
+    }
+    // skips whitespace up to the next token; false at EOF.
+    static bool skipSpace(Reader& r) {
+      for(;;) {
+        while(r.cur != r.end && Reader::isSpace(*r.cur)) r.cur++;
+        if(r.cur != r.end) return true;
+        if(!r.fill()) {
+          r.readEofChar();
+          return false;
+        }
+      }
+    }
+    // the bytes of the current token in the buffer of r, refilling it if
+    // needed; 0 at the end of the token.
+    static size_t tokenPiece(Reader& r) {
+      if(r.cur == r.end && !r.fill()) return 0;
+      return Reader::tokenCharset().span(r.cur, r.end);
+    }
+    static void takePiece(Reader& r, size_t n, std::string& prefix, size_t& len) {
+      if(len < PREFIX_SIZE) prefix.append(r.cur, std::min(n, PREFIX_SIZE - len));
+      r.cur += n;
+      len += n;
+    }
+    // Compares tokens that cross a block boundary piece by piece, so that
+    // memory does not grow with their length.  The prefixes are left in
+    // expected_prefix and actual_prefix.
+    bool compareLongTokens(bool has_exp, bool has_act, size_t& exp_len, size_t& act_len) {
+      expected_prefix.clear();
+      actual_prefix.clear();
+      exp_len = act_len = 0;
+      bool equal = has_exp && has_act;
+      for(;;) {
+        const size_t e = has_exp ? tokenPiece(expected) : 0;
+        const size_t a = has_act ? tokenPiece(actual) : 0;
+        if(e == 0 && a == 0) break;
+        if(e == 0 || a == 0) equal = false;
+        const size_t n = std::min(e, a);
+        if(equal && n > 0) {
+          equal = ignore_case ? equalIgnoringCase(expected.cur, actual.cur, n) : memcmp(expected.cur, actual.cur, n) == 0;
+        }
+        // once unequal, each side runs to the end of its token alone.
+        takePiece(expected, equal ? n : e, expected_prefix, exp_len);
+        takePiece(actual, equal ? n : a, actual_prefix, act_len);
       }
-      close(pipe_p2c[0]); close(pipe_c2p[1]);
-      write_file = fdopen(pipe_p2c[1], "w");
-      read_file = fdopen(pipe_c2p[0], "r");
-      this->procname = new char[strlen(file)+1];
-      this->read_file = read_file;
-      this->write_file = write_file;
-      this->pid = pid;
-      this->line = 1;
-      this->arg0 = NULL;
-      this->args.clear();
-      strcpy(this->procname, file);
-      open(read_file, procname);
+      if(equal) return true;
+      // only numbers can match otherwise, and those fit in the prefixes.
+      return has_exp && has_act && exp_len <= PREFIX_SIZE && act_len <= PREFIX_SIZE &&
+        sameToken(expected_prefix.data(), exp_len, actual_prefix.data(), act_len);
     }
-    void closeProcess() {
-      if(write_file) {
-        fclose(write_file);
+    void compareTokens() {
+      const Charset& cs = Reader::tokenCharset();
+      for(long long index = 0; ; index++) {
+        const bool has_exp = skipSpace(expected);
+        const bool has_act = skipSpace(actual);
+        if(!has_exp && !has_act) break;
+        if(has_exp && has_act) {
+          const char *exp = expected.cur, *act = actual.cur;
+          const size_t exp_len = cs.span(exp, expected.end), act_len = cs.span(act, actual.end);
+          if(exp + exp_len != expected.end && act + act_len != actual.end) {
+            expected.cur += exp_len;
+            actual.cur += act_len;
+            if(sameToken(exp, exp_len, act, act_len)) continue;
+            setIndexName(actual, "token", index);
+            report("expected "+describeToken(exp, exp_len, true)+", found "+describeToken(act, act_len, true));
+          }
+        }
+        size_t exp_len, act_len;
+        if(compareLongTokens(has_exp, has_act, exp_len, act_len)) continue;
+        setIndexName(actual, "token", index);
+        report("expected "+describeToken(expected_prefix.data(), exp_len, has_exp)+", found "+describeToken(actual_prefix.data(), act_len, has_act));
       }
-      dispose();
-      int status;
-      waitpid(pid, &status, WUNTRACED);
-      if(!WIFEXITED(status)) {
-        throw ProcessError(std::string(procname)+": exited abnormally");
+    }
+  public:
+    Comparator(Reader& expected, Reader& actual, Mode mode = TOKENS)
+      : expected(expected), actual(actual), mode(mode), ignore_case(false),
+        abs_eps(-1), rel_eps(-1) {}
+    // TOKENS only: compares letters case-insensitively.
+    Comparator& ignoreCase(bool enable = true) {
+      ignore_case = enable;
+      return *this;
+    }
+    // TOKENS only: numbers match if their absolute or relative (to the
+    // expected value) difference is within the given bound; negative
+    // disables that bound.
+    Comparator& setTolerance(double abs_eps, double rel_eps) {
+      this->abs_eps = abs_eps;
+      this->rel_eps = rel_eps;
+      return *this;
+    }
+    // Compares both to the end, and then closes them.
+    void compare() {
+      if(mode == EXACT) {
+        compareExact();
+      } else {
+        compareTokens();
       }
-      if(WEXITSTATUS(status) != 0) {
-        throw ProcessError(std::string(procname)+": exited with status "+itos(WEXITSTATUS(status)));
+      expected.readEof();
+      actual.readEof();
+    }
+  };
+
+  ////
+  //// Tools for Test Generation
+  ////
+
+  // Buffered output: the counterpart of Reader for generators.  Writes
+  // to stdout, to a file, or (default constructor) to memory.  Errors
+  // are thrown as std::runtime_error; the destructor flushes quietly.
+  class Writer : private Uncopyable {
+    static const size_t WRITE_BUFFER_SIZE = 1 << 16;
+    int fd;  // -1: in memory
+    bool owns_fd;
+    std::vector<char> buf;
+    size_t len;
+    // returns room for n more bytes at the end of the buffer.
+    char *reserve(size_t n) {
+      if(len + n > buf.size()) {
+        if(fd >= 0) flush();
+        if(len + n > buf.size()) buf.resize(std::max(buf.size() * 2, len + n));
       }
-      write_file = read_file = NULL;
-      pid = 0;
+      return &buf[len];
     }
-    Process() {
-      init();
+    // takes the bytes from the end of the buffer up to p.
+    void commit(char *p) {
+      len = p - &buf[0];
     }
-    ~Process() {
-      if(pid) {
-        closeProcess();
+    void writeRaw(const char *data, size_t n) {
+      while(n > 0) {
+        ssize_t k = ::write(fd, data, n);
+        if(k < 0) {
+          if(errno == EINTR) continue;
+          throw std::runtime_error(std::string("error writing file: ")+detail::errorString(errno));
+        }
+        data += k;
+        n -= k;
       }
-      if(linecache) {
-        delete linecache;
-        delete[] prtcache;
+    }
+    template<typename T>
+    Writer& writeArray(const T *vals, int n, char sep) {
+      if(n < 0) throw std::invalid_argument("Writer::writeArray: n is negative");
+      for(int i = 0; i < n; i++) {
+        char *p = reserve(LTOS_BUFFER_SIZE + 1);
+        p = std::copy(detail::formatDecimal(p + LTOS_BUFFER_SIZE, vals[i]), p + LTOS_BUFFER_SIZE, p);
+        *p++ = i+1 < n ? sep : '\n';
+        commit(p);
       }
-      delete[] procname;
+      if(n == 0) writeLine();
+      return *this;
     }
-    void closeWriting() {
-      fclose(write_file);
-      write_file = NULL;
+  public:
+    Writer() : fd(-1), owns_fd(false), buf(256), len(0) {}
+    Writer(FILE *fp) : fd(-1), owns_fd(false), buf(WRITE_BUFFER_SIZE), len(0) {
+      if(fp != stdout) {
+        throw std::invalid_argument("Writer(FILE*): fp must be stdout.");
+      }
+      fflush(stdout);
+      fd = fileno(stdout);
     }
-    int vscanf(const char *format, va_list ap) {
-      abortReading();
-      return vfscanf(read_file, format, ap);
+    Writer(const char *filename) : fd(-1), owns_fd(true), buf(WRITE_BUFFER_SIZE), len(0) {
+      fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      if(fd < 0) {
+        throw std::runtime_error(std::string("Writer(const char*): error opening file: ")+detail::errorString(errno));
+      }
     }
-    int vprintf(const char *format, va_list ap) {
-      if(linecache) {
-        int retval = vsnprintf(prtcache, 1000, format, ap);
-        if(retval >= 999) {
-          throw std::runtime_error("ProcessImpl::vprintf(const char*,va_list): "
-              "due to va_list restriction, cannot output 1000 or more characters at once "
-              "in IODump mode.");
-        }
-        for(int i = 0; prtcache[i]; i++) {
-          if(prtcache[i]=='\n') {
-            fprintf(stderr, "%s<out>: %2d: %s\n", procname, line++, linecache->c_str());
-            linecache->clear();
-          } else {
-            linecache->push_back(prtcache[i]);
-          }
-        }
-        return fprintf(write_file, "%s", prtcache);
-      } else {
-        return vfprintf(write_file, format, ap);
+    ~Writer() {
+      try {
+        close();
+      } catch(const std::runtime_error&) {
       }
     }
-    int flush() {
-      return fflush(write_file);
+    // Sends the buffered output to the file.  No effect in memory.
+    void flush() {
+      if(fd < 0) return;
+      const size_t n = len;
+      len = 0;
+      writeRaw(&buf[0], n);
     }
-    void enableIODump() {
-      if(!linecache) {
-        linecache = new std::string();
-        prtcache = new char[1000];
-        Reader::enableIODump();
+    // Flushes, and closes the file if the Writer opened it.
+    void close() {
+      flush();
+      if(owns_fd && fd >= 0) {
+        int ret = ::close(fd);
+        fd = -1;
+        if(ret < 0) throw std::runtime_error(std::string("error writing file: ")+detail::errorString(errno));
       }
     }
 
-    Process& push(const char *argval) {
-      args.push_back(argval);
+    // The contents of an in-memory Writer.
+    const char *data() const { return &buf[0]; }
+    size_t size() const { return len; }
+    void clear() { len = 0; }
+
+    Writer& write(const char *data, size_t n) {
+      if(fd >= 0 && n >= WRITE_BUFFER_SIZE) {
+        flush();
+        writeRaw(data, n);
+        return *this;
+      }
+      char *p = reserve(n);
+      memcpy(p, data, n);
+      commit(p + n);
       return *this;
     }
-    Process& push(const char **argval) {
-      for(int i = 0; argval[i]; i++) {
-        args.push_back(argval[i]);
-      }
+    Writer& write(const Writer& other) {
+      return write(other.data(), other.size());
+    }
+    Writer& writeString(StringView s) {
+      return write(s.data(), s.size());
+    }
+    Writer& writeInt(int val) {
+      return writeLong(val);
+    }
+    Writer& writeLong(long long val) {
+      char *p = reserve(LTOS_BUFFER_SIZE);
+      commit(std::copy(detail::formatDecimal(p + LTOS_BUFFER_SIZE, val), p + LTOS_BUFFER_SIZE, p));
       return *this;
     }
-    Process& push(char **argval) {
-      for(int i = 0; argval[i]; i++) {
-        args.push_back(argval[i]);
+    // Fixed-point notation with the given number of decimals, as read
+    // back by Reader::readDouble.
+    Writer& writeDouble(double val, int decimals) {
+      char tmp[32];
+      int n = snprintf(tmp, sizeof(tmp), "%.*f", decimals, val);
+      if(n >= (int)sizeof(tmp)) {
+        std::vector<char> big(n + 1);
+        snprintf(&big[0], n + 1, "%.*f", decimals, val);
+        return write(&big[0], n);
       }
-      return *this;
+      return write(tmp, n);
     }
-    Process& setExecFile(const char *argval) {
-      arg0 = argval;
+    Writer& writeChar(char c) {
+      char *p = reserve(1);
+      *p = c;
+      commit(p + 1);
       return *this;
     }
-
-    int scanf(const char *format, ...) ATTR_SCANF(2,3) {
-      va_list ap;
-      va_start(ap, format);
-      int ret = vscanf(format, ap);
-      va_end(ap);
-      return ret;
+    Writer& writeSpace() {
+      return writeChar(' ');
+    }
+    Writer& writeLine() {
+      return writeChar('\n');
+    }
+    // Writes n values separated by sep and followed by a newline.
+    Writer& writeInts(const int *vals, int n, char sep = ' ') {
+      return writeArray(vals, n, sep);
+    }
+    Writer& writeInts(const std::vector<int>& vals, char sep = ' ') {
+      return writeArray(vals.empty() ? NULL : &vals[0], (int)vals.size(), sep);
+    }
+    Writer& writeLongs(const long long *vals, int n, char sep = ' ') {
+      return writeArray(vals, n, sep);
+    }
+    Writer& writeLongs(const std::vector<long long>& vals, char sep = ' ') {
+      return writeArray(vals.empty() ? NULL : &vals[0], (int)vals.size(), sep);
+    }
+    int vprintf(const char *format, va_list ap) {
+      va_list ap2;
+      CHECKERLIB_VA_COPY(ap2, ap);
+      const size_t room = buf.size() - len;
+      int n = vsnprintf(&buf[0] + len, room, format, ap);
+      if(n >= 0 && (size_t)n >= room) {
+        char *p = reserve(n + 1);
+        vsnprintf(p, n + 1, format, ap2);
+      }
+      if(n >= 0) len += n;
+      va_end(ap2);
+      return n;
     }
     int printf(const char *format, ...) ATTR_PRINTF(2,3) {
       va_list ap;
       va_start(ap, format);
-      int ret = vprintf(format, ap);
+      int n = vprintf(format, ap);
       va_end(ap);
-      return ret;
+      return n;
+    }
+  };
+
+  // Counter-based pseudo-random numbers (SplitMix64): the k-th output
+  // is a function of the seed and k alone, so a generator can jump
+  // ahead in O(1), and split() gives independent streams, e.g. one per
+  // chunk of a parallel generator.
+  class Random {
+    unsigned long long seed, counter;
+    static unsigned long long mix(unsigned long long z) {
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+  public:
+    explicit Random(unsigned long long seed = 0) : seed(seed), counter(0) {}
+    unsigned long long next() {
+      return mix(seed + ++counter * 0x9E3779B97F4A7C15ULL);
+    }
+    // Skips n outputs.
+    void jump(unsigned long long n) {
+      counter += n;
+    }
+    // The number of outputs drawn (or skipped) so far.
+    unsigned long long position() const {
+      return counter;
+    }
+    // The stream-th substream; the same seed and stream always give the
+    // same numbers, whatever was drawn from this generator.
+    Random split(unsigned long long stream) const {
+      return Random(mix(mix(seed) ^ (stream * 0xD1B54A32D192ED03ULL + 0x9E3779B97F4A7C15ULL)));
+    }
+    // Uniform in [0,n), without modulo bias.
+    unsigned long long nextBelow(unsigned long long n) {
+      if(n == 0) throw std::invalid_argument("Random::nextBelow: n is zero");
+      const unsigned long long reject = (0 - n) % n;
+      for(;;) {
+        const unsigned long long r = next();
+        if(r >= reject) return r % n;
+      }
+    }
+    // Uniform in [lo,hi].
+    long long nextLong(long long lo, long long hi) {
+      if(lo > hi) throw std::invalid_argument("Random::nextLong: lo > hi");
+      const unsigned long long span = (unsigned long long)hi - (unsigned long long)lo;
+      return (long long)((unsigned long long)lo + (span == ~0ULL ? next() : nextBelow(span + 1)));
+    }
+    int nextInt(int lo, int hi) {
+      return (int)nextLong(lo, hi);
+    }
+    // Uniform in [0,1), with 53 random bits.
+    double nextDouble() {
+      return (next() >> 11) * (1.0 / 9007199254740992.0);
     }
   };
 
+  namespace detail {
+    template<typename F>
+    struct GenerateTask {
+      F *func;
+      int chunk;
+      Writer out;
+      std::string error;
+      static void *run(void *arg) {
+        GenerateTask *task = (GenerateTask *)arg;
+        try {
+          (*task->func)(task->out, task->chunk);
+        } catch(const std::exception& e) {
+          task->error = e.what();
+        }
+        return NULL;
+      }
+    };
+  }
+
+  // Calls func(Writer& chunk_out, int chunk) for chunk = 0, ...,
+  // num_chunks-1, up to threads at a time (0: one per online processor),
+  // and appends the chunks to out in order.  The output does not depend
+  // on the number of threads as long as each chunk only depends on its
+  // index, e.g. by drawing from Random(seed).split(chunk).  An exception
+  // from func is rethrown as std::runtime_error.
+  template<typename F>
+  void generateChunks(Writer& out, int num_chunks, F func, int threads = 0) {
+    if(threads <= 0) threads = detail::onlineProcessors();
+    threads = std::max(1, std::min(threads, num_chunks));
+    detail::GenerateTask<F> *tasks = new detail::GenerateTask<F>[threads];
+    std::string error;
+    try {
+      for(int first = 0; first < num_chunks && error.empty(); first += threads) {
+        const int wave = std::min(threads, num_chunks - first);
+        for(int i = 0; i < wave; i++) {
+          tasks[i].func = &func;
+          tasks[i].chunk = first + i;
+          tasks[i].out.clear();
+        }
+        detail::runParallel(tasks, wave, detail::GenerateTask<F>::run);
+        for(int i = 0; i < wave && error.empty(); i++) {
+          error = tasks[i].error;
+          if(error.empty()) out.write(tasks[i].out);
+        }
+      }
+    } catch(...) {
+      delete[] tasks;
+      throw;
+    }
+    delete[] tasks;
+    if(!error.empty()) throw std::runtime_error(error);
+  }
+
   ////
   //// Algorithm Tools
   ////
 
-  template<typename T, typename Iterator>
-  void checkUniqueImpl(Iterator begin, Iterator end, const char *varname) {
-    int size = end-begin;
-    std::pair<T,int>* array = new std::pair<T,int>[size];
-    for(int i = 0; i < size; i++) {
-      array[i].first = begin[i];
-      array[i].second = i;
+  namespace detail {
+    // Maps integral values to unsigned keys with the same ordering.
+    template<typename T> struct RadixTraits {
+      static const bool enabled = false;
+    };
+#define CHECKERLIB_RADIX_TRAITS(T, K, SIGNBIT) \
+    template<> struct RadixTraits<T> { \
+      static const bool enabled = true; \
+      typedef K Key; \
+      static Key key(T v) { return (Key)v ^ (SIGNBIT); } \
+    };
+    CHECKERLIB_RADIX_TRAITS(char, unsigned char, (CHAR_MIN < 0 ? 0x80 : 0))
+    CHECKERLIB_RADIX_TRAITS(signed char, unsigned char, 0x80)
+    CHECKERLIB_RADIX_TRAITS(unsigned char, unsigned char, 0)
+    CHECKERLIB_RADIX_TRAITS(short, unsigned short, (unsigned short)1 << (sizeof(short)*8-1))
+    CHECKERLIB_RADIX_TRAITS(unsigned short, unsigned short, 0)
+    CHECKERLIB_RADIX_TRAITS(int, unsigned int, 1U << (sizeof(int)*8-1))
+    CHECKERLIB_RADIX_TRAITS(unsigned int, unsigned int, 0)
+    CHECKERLIB_RADIX_TRAITS(long, unsigned long, 1UL << (sizeof(long)*8-1))
+    CHECKERLIB_RADIX_TRAITS(unsigned long, unsigned long, 0)
+    CHECKERLIB_RADIX_TRAITS(long long, unsigned long long, 1ULL << 63)
+    CHECKERLIB_RADIX_TRAITS(unsigned long long, unsigned long long, 0)
+#undef CHECKERLIB_RADIX_TRAITS
+
+    // In-place MSD radix sort (American flag sort) on the byte at shift
+    // and below.
+    template<typename K>
+    void radixSort(K *a, size_t n, int shift) {
+      if(n < 64) {
+        std::sort(a, a+n);
+        return;
+      }
+      size_t count[256] = {0}, head[256], tail[256];
+      for(size_t i = 0; i < n; i++) {
+        count[(a[i] >> shift) & 255]++;
+      }
+      for(size_t b = 0, pos = 0; b < 256; b++) {
+        head[b] = pos;
+        pos += count[b];
+        tail[b] = pos;
+      }
+      for(int b = 0; b < 256; b++) {
+        while(head[b] < tail[b]) {
+          K v = a[head[b]];
+          int d;
+          while((d = (v >> shift) & 255) != b) {
+            std::swap(v, a[head[d]++]);
+          }
+          a[head[b]++] = v;
+        }
+      }
+      if(shift == 0) return;
+      for(size_t b = 0, pos = 0; b < 256; pos += count[b], b++) {
+        if(count[b] > 1) radixSort(a+pos, count[b], shift-8);
+      }
+    }
+
+    template<typename K>
+    struct RadixBuckets {
+      std::vector<std::pair<K *, size_t> > buckets;
+      int shift;
+      static void *run(void *arg) {
+        RadixBuckets *task = (RadixBuckets *)arg;
+        for(size_t i = 0; i < task->buckets.size(); i++) {
+          radixSort(task->buckets[i].first, task->buckets[i].second, task->shift);
+        }
+        return NULL;
+      }
+    };
+
+    // Sorts the keys, recursing into the top-level buckets on up to
+    // threads threads (largest bucket first onto the least loaded one).
+    template<typename K>
+    void radixSort(K *a, size_t n, int threads, int shift) {
+      if(threads <= 1 || n < (1 << 16)) {
+        radixSort(a, n, shift);
+        return;
+      }
+      size_t count[256] = {0}, head[256], tail[256];
+      for(size_t i = 0; i < n; i++) {
+        count[(a[i] >> shift) & 255]++;
+      }
+      std::vector<std::pair<size_t, int> > order;
+      for(size_t b = 0, pos = 0; b < 256; b++) {
+        head[b] = pos;
+        pos += count[b];
+        tail[b] = pos;
+        if(count[b] > 1) order.push_back(std::make_pair(count[b], (int)b));
+      }
+      for(int b = 0; b < 256; b++) {
+        while(head[b] < tail[b]) {
+          K v = a[head[b]];
+          int d;
+          while((d = (v >> shift) & 255) != b) {
+            std::swap(v, a[head[d]++]);
+          }
+          a[head[b]++] = v;
+        }
+      }
+      if(shift == 0) return;
+      std::sort(order.rbegin(), order.rend());
+      std::vector<RadixBuckets<K> > tasks(threads);
+      std::vector<size_t> load(threads, 0);
+      for(size_t i = 0; i < order.size(); i++) {
+        int t = std::min_element(load.begin(), load.end()) - load.begin();
+        int b = order[i].second;
+        tasks[t].buckets.push_back(std::make_pair(a + tail[b] - count[b], count[b]));
+        tasks[t].shift = shift-8;
+        load[t] += count[b];
+      }
+      runParallel(&tasks[0], threads, RadixBuckets<K>::run);
+    }
+
+    inline unsigned long long mixHash(unsigned long long x) {
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdULL;
+      x ^= x >> 33;
+      x *= 0xc4ceb9fe1a85ec53ULL;
+      x ^= x >> 33;
+      return x;
     }
-    sort(array, array+size);
-    for(int i = 1; i < size; i++) {
-      if(array[i-1].first == array[i].first) {
-        int idx1 = min(array[i-1].second, array[i].second);
-        int idx2 = max(array[i-1].second, array[i].second);
-        delete[] array;
-        throw ParseError(std::string("Not Unique: ")+varname+"["+itos(idx1)+"]"+" == "+varname+"["+itos(idx2)+"]");
+
+    // Hashes for the types checked with a hash table by checkUnique.
+    template<typename T> struct UniqueHash {
+      static const bool enabled = RadixTraits<T>::enabled;
+      static unsigned long long hash(const T& v) {
+        return mixHash((unsigned long long)RadixTraits<T>::key(v));
+      }
+    };
+    template<> struct UniqueHash<std::string> {
+      static const bool enabled = true;
+      static unsigned long long hash(const std::string& v) {
+        unsigned long long h = 14695981039346656037ULL;
+        for(size_t i = 0; i < v.size(); i++) {
+          h = (h ^ (unsigned char)v[i]) * 1099511628211ULL;
+        }
+        return mixHash(h);
+      }
+    };
+    template<> struct UniqueHash<double> {
+      static const bool enabled = true;
+      static unsigned long long hash(const double& v) {
+        double normalized = v == 0 ? 0.0 : v;
+        unsigned long long bits;
+        memcpy(&bits, &normalized, sizeof(bits));
+        return mixHash(bits);
+      }
+    };
+    template<> struct UniqueHash<float> {
+      static const bool enabled = true;
+      static unsigned long long hash(const float& v) {
+        return UniqueHash<double>::hash(v);
       }
+    };
+    template<typename A, typename B> struct UniqueHash<std::pair<A,B> > {
+      static const bool enabled = UniqueHash<A>::enabled && UniqueHash<B>::enabled;
+      static unsigned long long hash(const std::pair<A,B>& v) {
+        return mixHash(UniqueHash<A>::hash(v.first) * 31 + UniqueHash<B>::hash(v.second));
+      }
+    };
+
+    inline void throwNotUnique(const char *varname, int idx1, int idx2) ATTR_NORETURN;
+    inline void throwNotUnique(const char *varname, int idx1, int idx2) {
+      throw ParseError(std::string("Not Unique: ")+varname+"["+itos(idx1)+"]"+" == "+varname+"["+itos(idx2)+"]");
     }
-    delete[] array;
+
+    // Every method reports the lexicographically smallest pair (i, j)
+    // with i < j and begin[i] == begin[j].
+    template<typename T, typename Iterator, int Method>
+    struct UniqueChecker;
+
+    // Integral values: radix-sort a copy of the keys, keep the distinct
+    // duplicated keys in front, and locate the first of them by index.
+    template<typename T, typename Iterator>
+    struct UniqueChecker<T, Iterator, 0> {
+      static void check(Iterator begin, int size, const char *varname, int threads) {
+        typedef typename RadixTraits<T>::Key Key;
+        std::vector<Key> keys(size);
+        for(int i = 0; i < size; i++) {
+          keys[i] = RadixTraits<T>::key(begin[i]);
+        }
+        if(size > 0) radixSort(&keys[0], keys.size(), threads, (int)(sizeof(Key)-1)*8);
+        size_t dups = 0;
+        for(size_t i = 0; i < keys.size(); ) {
+          size_t j = i+1;
+          while(j < keys.size() && keys[j] == keys[i]) j++;
+          if(j - i > 1) keys[dups++] = keys[i];
+          i = j;
+        }
+        if(dups == 0) return;
+        for(int i = 0; i < size; i++) {
+          Key k = RadixTraits<T>::key(begin[i]);
+          if(std::binary_search(keys.begin(), keys.begin()+dups, k)) {
+            int j = i+1;
+            while(RadixTraits<T>::key(begin[j]) != k) j++;
+            throwNotUnique(varname, i, j);
+          }
+        }
+      }
+    };
+
+    // Hashable values: an open-addressing table of first occurrences.
+    // The table of indices takes at most as much memory as the values
+    // (2n slots when that fits, load factor 1/2); for 4-byte types it
+    // needs 1.5n slots, i.e. 1.5 times the values.
+    template<typename T, typename Iterator>
+    struct UniqueChecker<T, Iterator, 1> {
+      static void check(Iterator begin, int size, const char *varname, int) {
+        const size_t n = size;
+        const size_t budget = n * sizeof(T) / sizeof(int);
+        const size_t capacity = std::max(n + n/2 + 16, std::min(2*n, budget));
+        std::vector<int> table(capacity, -1);
+        int idx1 = -1, idx2 = -1;
+        for(int j = 0; j < size; j++) {
+          // maps the upper hash bits onto [0, capacity).
+          size_t h = (size_t)(((UniqueHash<T>::hash(begin[j]) >> 32) * capacity) >> 32);
+          while(table[h] >= 0 && !(begin[table[h]] == begin[j])) {
+            if(++h == capacity) h = 0;
+          }
+          if(table[h] < 0) {
+            table[h] = j;
+          } else if(idx1 < 0 || table[h] < idx1) {
+            idx1 = table[h];
+            idx2 = j;
+          }
+        }
+        if(idx1 >= 0) throwNotUnique(varname, idx1, idx2);
+      }
+    };
+
+    // Anything else: sort (value, index) pairs.
+    template<typename T, typename Iterator>
+    struct UniqueChecker<T, Iterator, 2> {
+      static void check(Iterator begin, int size, const char *varname, int) {
+        std::vector<std::pair<T,int> > array(size);
+        for(int i = 0; i < size; i++) {
+          array[i].first = begin[i];
+          array[i].second = i;
+        }
+        std::sort(array.begin(), array.end());
+        int idx1 = -1, idx2 = -1;
+        for(int i = 1; i < size; i++) {
+          if(array[i-1].first == array[i].first && (i < 2 || !(array[i-2].first == array[i].first))) {
+            if(idx1 < 0 || array[i-1].second < idx1) {
+              idx1 = array[i-1].second;
+              idx2 = array[i].second;
+            }
+          }
+        }
+        if(idx1 >= 0) throwNotUnique(varname, idx1, idx2);
+      }
+    };
+  }
+
+  template<typename T, typename Iterator>
+  void checkUniqueImpl(Iterator begin, Iterator end, const char *varname, int threads = 1) {
+    const int method =
+      detail::RadixTraits<T>::enabled ? 0 :
+      detail::UniqueHash<T>::enabled ? 1 : 2;
+    detail::UniqueChecker<T, Iterator, method>::check(begin, end-begin, varname, threads);
   }
 
+  // Throws ParseError naming the lowest pair of indices i < j with equal
+  // values.  Integral values are radix sorted; strings, floating point
+  // values and pairs of those are hashed; other types are sorted.  The
+  // hash table of indices is no larger than the values themselves, except
+  // for 4-byte values, where it is 1.5 times their size.
   template<typename T>
-  void checkUnique(const T* begin, const T* end, const char *format = "_", ...) {
-    char *varname = new char[1000];
+  void checkUnique(const T* begin, const T* end, const char *format = "_", ...) ATTR_PRINTF(3,4);
+  template<typename T>
+  void checkUnique(const T* begin, const T* end, const char *format, ...) {
+    char varname[1000];
     va_list ap;
     va_start(ap, format);
-    snprintf(varname, 1000, format, ap);
+    vsnprintf(varname, 1000, format, ap);
     va_end(ap);
 
     checkUniqueImpl<T,const T*>(begin, end, varname);
-    delete[] varname;
   }
 
   template<typename T>
-  void checkUnique(const std::vector<T>& vec, const char *format = "_", ...) {
-    char *varname = new char[1000];
+  void checkUnique(const std::vector<T>& vec, const char *format = "_", ...) ATTR_PRINTF(2,3);
+  template<typename T>
+  void checkUnique(const std::vector<T>& vec, const char *format, ...) {
+    char varname[1000];
+    va_list ap;
+    va_start(ap, format);
+    vsnprintf(varname, 1000, format, ap);
+    va_end(ap);
+
+    checkUniqueImpl<T,typename std::vector<T>::const_iterator>(vec.begin(), vec.end(), varname);
+  }
+
+  // Same as checkUnique, sorting integral values on the given number of
+  // threads (0: one per online processor).
+  template<typename T>
+  void checkUniqueParallel(const T* begin, const T* end, int threads, const char *format = "_", ...) ATTR_PRINTF(4,5);
+  template<typename T>
+  void checkUniqueParallel(const T* begin, const T* end, int threads, const char *format, ...) {
+    char varname[1000];
     va_list ap;
     va_start(ap, format);
-    snprintf(varname, 1000, format, ap);
+    vsnprintf(varname, 1000, format, ap);
     va_end(ap);
 
-    checkUniqueImpl<T,std::vector<T>::const_iterator>(vec.begin(), vec.end(), varname);
-    delete[] varname;
+    checkUniqueImpl<T,const T*>(begin, end, varname, threads ? threads : detail::onlineProcessors());
+  }
+
+  // Streaming checks: each value is passed through check() right after
+  // it is read, and errors are reported at the reader's position.
+  //
+  //   DistinctChecker<int> seen(1, N);
+  //   xs[i] = seen.check(in.readInt("xs[%d]", i).range(1, N)).ary(i, N);
+
+  // Rejects a value that was already seen.  Uses a bitset over
+  // [min_val, max_val] when that range is small (at most 2 MB of bits),
+  // or no larger than 64 bits per expected value; a hash set otherwise.
+  template<typename T>
+  class DistinctChecker {
+    static const unsigned long long BITSET_MAX_RANGE = 1ULL << 24;
+    T min_val, max_val;
+    std::vector<unsigned long long> bits;
+    std::vector<T> table;
+    std::vector<bool> used;
+    size_t count;
+    bool insertHashed(T v) {
+      if((count+1)*2 > table.size()) {
+        std::vector<T> old_table(table.size() ? table.size()*2 : 64);
+        std::vector<bool> old_used(old_table.size(), false);
+        old_table.swap(table);
+        old_used.swap(used);
+        count = 0;
+        for(size_t i = 0; i < old_table.size(); i++) {
+          if(old_used[i]) insertHashed(old_table[i]);
+        }
+      }
+      size_t mask = table.size()-1;
+      size_t h = detail::UniqueHash<T>::hash(v) & mask;
+      while(used[h]) {
+        if(table[h] == v) return false;
+        h = (h+1) & mask;
+      }
+      used[h] = true;
+      table[h] = v;
+      count++;
+      return true;
+    }
+  public:
+    // expected: the number of values to be added, if known (0: unknown).
+    DistinctChecker(T min_val, T max_val, size_t expected = 0)
+      : min_val(min_val), max_val(max_val), count(0) {
+      if(min_val > max_val) throw std::invalid_argument("DistinctChecker: empty range");
+      unsigned long long span = (unsigned long long)max_val - (unsigned long long)min_val;
+      if(span < BITSET_MAX_RANGE || span/64 < expected) {
+        bits.resize(span/64+1);
+      }
+    }
+    // Returns false if v is out of range or has been added before.
+    bool add(T v) {
+      if(!(min_val <= v && v <= max_val)) return false;
+      if(bits.empty()) return insertHashed(v);
+      unsigned long long offset = (unsigned long long)v - (unsigned long long)min_val;
+      unsigned long long bit = 1ULL << (offset % 64);
+      if(bits[offset/64] & bit) return false;
+      bits[offset/64] |= bit;
+      count++;
+      return true;
+    }
+    size_t size() const { return count; }
+    template<typename Data>
+    Data check(const Data& d) {
+      if(!(min_val <= d.getData() && d.getData() <= max_val)) {
+        d.getReader().abortReadingWithError("invalid range");
+      }
+      if(!add(d.getData())) {
+        d.getReader().abortReadingWithError("Not Unique: value appeared before");
+      }
+      return d;
+    }
+  };
+
+  // Checks that the values form a permutation of base, ..., base+n-1:
+  // each one is in range and new, and finish() verifies all n were read.
+  class PermutationChecker {
+    int n;
+    DistinctChecker<int> seen;
+  public:
+    PermutationChecker(int n, int base = 1)
+      : n(n), seen(base, base+std::max(n,1)-1, n) {}
+    template<typename Data>
+    Data check(const Data& d) {
+      return seen.check(d);
+    }
+    void finish(Reader& in) const {
+      if((int)seen.size() != n) {
+        in.abortReadingWithError("Not a permutation: "+itos(seen.size())+" of "+itos(n)+" values read");
+      }
+    }
+  };
+
+  // Checks that values are non-decreasing, or strictly increasing.
+  template<typename T>
+  class SortedChecker {
+    bool strict, has_last;
+    T last;
+  public:
+    SortedChecker(bool strict = false)
+      : strict(strict), has_last(false), last() {}
+    template<typename Data>
+    Data check(const Data& d) {
+      T v = d.getData();
+      if(has_last && (strict ? !(last < v) : v < last)) {
+        d.getReader().abortReadingWithError(strict ? "not strictly increasing" : "not non-decreasing");
+      }
+      has_last = true;
+      last = v;
+      return d;
+    }
+  };
+
+  ////
+  //// Graph Tools
+  ////
+
+  // Vertices are numbered base, ..., base+n-1; edge i is (us[i], vs[i]).
+
+  // Union by size; find() compresses the whole path to the root.
+  class UnionFind {
+    std::vector<int> parent;
+  public:
+    UnionFind(int n) : parent(n, -1) {}
+    int find(int v) {
+      int root = v;
+      while(parent[root] >= 0) root = parent[root];
+      while(parent[v] >= 0) {
+        int next = parent[v];
+        parent[v] = root;
+        v = next;
+      }
+      return root;
+    }
+    // returns false if a and b were already connected.
+    bool unite(int a, int b) {
+      a = find(a);
+      b = find(b);
+      if(a == b) return false;
+      if(parent[a] > parent[b]) std::swap(a, b);
+      parent[a] += parent[b];
+      parent[b] = a;
+      return true;
+    }
+    int size(int v) { return -parent[find(v)]; }
+  };
+
+  namespace detail {
+    inline std::string edgeDescription(const int *us, const int *vs, int i) {
+      return "edges["+itos(i)+"] = ("+itos(us[i])+", "+itos(vs[i])+")";
+    }
+    inline void checkVertices(int n, const int *us, const int *vs, int m, int base) {
+      for(int i = 0; i < m; i++) {
+        if(us[i] < base || us[i]-base >= n || vs[i] < base || vs[i]-base >= n) {
+          throw ParseError("Invalid Vertex: "+edgeDescription(us, vs, i));
+        }
+      }
+    }
+  }
+
+  inline void checkNoSelfLoops(const int *us, const int *vs, int m) {
+    for(int i = 0; i < m; i++) {
+      if(us[i] == vs[i]) {
+        throw ParseError("Self Loop: "+detail::edgeDescription(us, vs, i));
+      }
+    }
+  }
+
+  // Reports the lowest pair of parallel edges as "Not Unique: edges[i] ==
+  // edges[j]"; (u, v) and (v, u) are the same edge unless directed.
+  inline void checkNoMultiEdges(const int *us, const int *vs, int m, bool directed = false) {
+    std::vector<unsigned long long> keys(m);
+    for(int i = 0; i < m; i++) {
+      unsigned int u = us[i], v = vs[i];
+      if(!directed && us[i] > vs[i]) std::swap(u, v);
+      keys[i] = (unsigned long long)u << 32 | v;
+    }
+    checkUniqueImpl<unsigned long long>(keys.begin(), keys.end(), "edges");
+  }
+
+  inline void checkConnected(int n, const int *us, const int *vs, int m, int base = 1) {
+    detail::checkVertices(n, us, vs, m, base);
+    UnionFind uf(n);
+    int components = n;
+    for(int i = 0; i < m; i++) {
+      if(uf.unite(us[i]-base, vs[i]-base)) components--;
+    }
+    if(components <= 1) return;
+    for(int v = 1; v < n; v++) {
+      if(uf.find(v) != uf.find(0)) {
+        throw ParseError("Not Connected: vertex "+itos(base)+" and vertex "+itos(base+v));
+      }
+    }
+  }
+
+  inline void checkTree(int n, const int *us, const int *vs, int m, int base = 1) {
+    if(m != n-1) {
+      throw ParseError("Not a Tree: "+itos(n-1)+" edges expected, "+itos(m)+" given");
+    }
+    detail::checkVertices(n, us, vs, m, base);
+    UnionFind uf(n);
+    for(int i = 0; i < m; i++) {
+      if(!uf.unite(us[i]-base, vs[i]-base)) {
+        throw ParseError("Not a Tree: "+detail::edgeDescription(us, vs, i)+" closes a cycle");
+      }
+    }
+  }
+
+  // Edges are directed from us[i] to vs[i].
+  inline void checkDAG(int n, const int *us, const int *vs, int m, int base = 1) {
+    detail::checkVertices(n, us, vs, m, base);
+    // CSR adjacency: the successors of v are adj[start[v]], ..., adj[start[v+1]-1].
+    std::vector<int> start(n+1, 0), adj(m), indeg(n, 0);
+    for(int i = 0; i < m; i++) {
+      start[us[i]-base+1]++;
+      indeg[vs[i]-base]++;
+    }
+    for(int v = 0; v < n; v++) start[v+1] += start[v];
+    {
+      std::vector<int> pos(start.begin(), start.end()-1);
+      for(int i = 0; i < m; i++) adj[pos[us[i]-base]++] = vs[i]-base;
+    }
+    std::vector<int> queue;
+    queue.reserve(n);
+    for(int v = 0; v < n; v++) {
+      if(indeg[v] == 0) queue.push_back(v);
+    }
+    for(size_t head = 0; head < queue.size(); head++) {
+      int v = queue[head];
+      for(int k = start[v]; k < start[v+1]; k++) {
+        if(--indeg[adj[k]] == 0) queue.push_back(adj[k]);
+      }
+    }
+    if((int)queue.size() == n) return;
+    // Every remaining vertex has a remaining predecessor; walking back
+    // along those n times is guaranteed to end up on a cycle.
+    std::vector<int> pred(n, -1);
+    for(int i = 0; i < m; i++) {
+      if(indeg[us[i]-base] > 0 && indeg[vs[i]-base] > 0) pred[vs[i]-base] = us[i]-base;
+    }
+    int v = 0;
+    while(indeg[v] == 0) v++;
+    for(int k = 0; k < n; k++) v = pred[v];
+    throw ParseError("Not a DAG: cycle through vertex "+itos(base+v));
+  }
+
+  // The same checks on vectors; us and vs must have the same size.
+  inline void checkNoSelfLoops(const std::vector<int>& us, const std::vector<int>& vs) {
+    if(us.size() != vs.size()) throw std::invalid_argument("checkNoSelfLoops: us and vs differ in size");
+    checkNoSelfLoops(us.empty() ? NULL : &us[0], vs.empty() ? NULL : &vs[0], (int)us.size());
+  }
+  inline void checkNoMultiEdges(const std::vector<int>& us, const std::vector<int>& vs, bool directed = false) {
+    if(us.size() != vs.size()) throw std::invalid_argument("checkNoMultiEdges: us and vs differ in size");
+    checkNoMultiEdges(us.empty() ? NULL : &us[0], vs.empty() ? NULL : &vs[0], (int)us.size(), directed);
+  }
+  inline void checkConnected(int n, const std::vector<int>& us, const std::vector<int>& vs, int base = 1) {
+    if(us.size() != vs.size()) throw std::invalid_argument("checkConnected: us and vs differ in size");
+    checkConnected(n, us.empty() ? NULL : &us[0], vs.empty() ? NULL : &vs[0], (int)us.size(), base);
+  }
+  inline void checkTree(int n, const std::vector<int>& us, const std::vector<int>& vs, int base = 1) {
+    if(us.size() != vs.size()) throw std::invalid_argument("checkTree: us and vs differ in size");
+    checkTree(n, us.empty() ? NULL : &us[0], vs.empty() ? NULL : &vs[0], (int)us.size(), base);
+  }
+  inline void checkDAG(int n, const std::vector<int>& us, const std::vector<int>& vs, int base = 1) {
+    if(us.size() != vs.size()) throw std::invalid_argument("checkDAG: us and vs differ in size");
+    checkDAG(n, us.empty() ? NULL : &us[0], vs.empty() ? NULL : &vs[0], (int)us.size(), base);
   }
 }
 
@@ -684,5 +4832,12 @@ namespace checker {
 #undef ATTR_SCANF
 #undef ATTR_NORETURN
 #endif
+#undef CHECKERLIB_VA_COPY
+#undef CHECKERLIB_EXACT_DOUBLE
+#undef CHECKERLIB_COUNT
+#undef CHECKERLIB_DECOMPRESS
+#undef CHECKERLIB_CXX11
+#undef CHECKERLIB_CXX17
+#undef CHECKERLIB_THROWING_DTOR
 
 #endif /* CHECKERLIB_H */
@@ -0,0 +1,15 @@
+// sample10.cpp: output checker with a tolerance for real numbers
+#include "checkerlib.h"
+using namespace checker;
+
+int main(int argc, char *argv[]) {
+  if(argc != 3) {
+    fprintf(stderr, "usage: %s expected actual\n", argv[0]);
+    return 2;
+  }
+  Reader expected(argv[1]);
+  Reader actual(argv[2]);
+  Comparator(expected, actual).setTolerance(1e-6, 1e-6).compare();
+  printf("Correct.\n");
+  return 0;
+}
@@ -0,0 +1,17 @@
+// sample11.cpp: read N points with coordinates given to at most 6 decimals
+#include "checkerlib.h"
+using namespace checker;
+
+const int MAX_N = 100000;
+const double MAX_COORD = 10000.0;
+
+int main() {
+  Reader in(stdin);
+  const int N = in.readInt("N").range(1,MAX_N).eol();
+  for(int i = 0; i < N; i++) {
+    in.readDouble(6, "x[%d]", i).range(-MAX_COORD,MAX_COORD).spc();
+    in.readDouble(6, "y[%d]", i).range(-MAX_COORD,MAX_COORD).eol();
+  }
+  in.readEof();
+  return 0;
+}
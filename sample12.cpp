@@ -0,0 +1,19 @@
+// sample12.cpp: read a lowercase string S and M names on one line
+#include "checkerlib.h"
+using namespace checker;
+
+const int MAX_N = 1000000;
+const int MAX_M = 100;
+
+int main() {
+  Reader in(stdin);
+  const Charset lower("a-z"), alpha("A-Za-z");
+  const int N = in.readInt("N").range(1,MAX_N).eol();
+  in.readString(N, N, lower, "S").eol();
+  const int M = in.readInt("M").range(1,MAX_M).eol();
+  for(int i = 0; i < M; i++) {
+    in.readString(1, 10, alpha, "name[%d]", i).ary(i, M);
+  }
+  in.readEof();
+  return 0;
+}
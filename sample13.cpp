@@ -0,0 +1,21 @@
+// sample13.cpp: validate many input files of sample1 in one process
+//
+// usage: ./sample13 file-or-directory...
+#include "checkerlib.h"
+using namespace checker;
+
+void validate(Reader& in) {
+  in.readInt("a").range(-100,100).spc();
+  in.readInt("b").range(-100,100).eol();
+  in.readEof();
+}
+
+int main(int argc, char *argv[]) {
+  if(argc < 2) {
+    fprintf(stderr, "usage: %s file-or-directory...\n", argv[0]);
+    return 1;
+  }
+  std::vector<BatchValidator::Result> results =
+    BatchValidator().addPaths(argv+1).run(validate);
+  return BatchValidator::printSummary(results) ? 1 : 0;
+}
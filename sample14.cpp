@@ -0,0 +1,28 @@
+// sample14.cpp: validate an array and range queries with a schema (C++11)
+//
+// N M
+// A_1 ... A_N      (1 <= A_i <= 10^9)
+// l_1 r_1          (1 <= l_i <= r_i <= N)
+// ...
+// l_M r_M
+#include "checkerlib.h"
+using namespace checker;
+using namespace checker::schema;
+
+typedef Input<
+  Line<Int<Const<1>, Const<200000>>, Int<Const<0>, Const<200000>>>,
+  Line<Array<Var<0>, Int<Const<1>, Const<1000000000>>>>,
+  Lines<Var<1>, Line<Int<Const<1>, Var<0>>, Int<Var<2>, Var<0>>>>
+> Format;
+
+int main() {
+  try {
+    Reader in(stdin);
+    Format::Values v = Format::read(in, "N M A l r");
+    printf("N = %lld, M = %lld\n", v[0], v[1]);
+  } catch(const ParseError& err) {
+    fprintf(stderr, "%s\n", err.what());
+    return 1;
+  }
+  return 0;
+}
@@ -27,12 +27,14 @@ inline long long rand_pos() {
 
 int main() {
   const int N = MAX_N;
-  printf("%d\n", N);
+  Writer out(stdout);
+  out.writeInt(N).writeLine();
   for(int i = 0; i < N; i++) {
     long long x = rand_pos();
     long long y = rand_pos();
-    printf("%lld %lld\n", x, y);
+    out.writeLong(x).writeSpace().writeLong(y).writeLine();
   }
+  out.flush();
   return 0;
 }
 
@@ -0,0 +1,28 @@
+// sample4-pgen.cpp: input for sample4, generated in parallel chunks; the
+// output only depends on SEED, not on the number of threads.
+#include "checkerlib.h"
+using namespace checker;
+
+const int MAX_N = 1000000;
+const long long MIN_POS = -1000000000000LL;
+const long long MAX_POS =  1000000000000LL;
+const unsigned long long SEED = 20140501;
+const int CHUNK = 1 << 16;
+
+void generate(Writer& out, int chunk) {
+  Random rng = Random(SEED).split(chunk);
+  const int end = std::min(MAX_N, (chunk + 1) * CHUNK);
+  for(int i = chunk * CHUNK; i < end; i++) {
+    out.writeLong(rng.nextLong(MIN_POS, MAX_POS)).writeSpace();
+    out.writeLong(rng.nextLong(MIN_POS, MAX_POS)).writeLine();
+  }
+}
+
+int main(int argc, char *argv[]) {
+  const int threads = argc > 1 ? atoi(argv[1]) : 0;
+  Writer out(stdout);
+  out.writeInt(MAX_N).writeLine();
+  generateChunks(out, (MAX_N + CHUNK - 1) / CHUNK, generate, threads);
+  out.flush();
+  return 0;
+}
@@ -32,7 +32,7 @@ int main(int argc, char *argv[]) {
         break;
       }
       const int guess = p.readInt("guess[%d]",count).range(0,N-1).eol();
-      p.printf("%d\n", xs[guess]);
+      p.writeInt(xs[guess]).writeLine();
       p.flush();
       if(xs[guess] == 0) {
         break;
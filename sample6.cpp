@@ -0,0 +1,26 @@
+// sample6.cpp: read 2N large integers (bulk reader)
+//
+// usage: ./sample6 [threads] < input
+#include "checkerlib.h"
+using namespace checker;
+
+const int MAX_N = 1000000;
+const long long MIN_POS = -1000000000000LL;
+const long long MAX_POS =  1000000000000LL;
+
+int main(int argc, char *argv[]) {
+  try {
+    Reader in(stdin);
+    if(argc > 1) in.enableParallelReading(atoi(argv[1]));
+    const int N = in.readInt("N").range(1,MAX_N).eol();
+    static long long xs[MAX_N], ys[MAX_N];
+    in.readLongPairs(xs, ys, N, MIN_POS, MAX_POS, "xs", "ys");
+    in.readEof();
+  } catch(const ParseError& err) {
+    fprintf(stderr, "%s\n", err.what());
+    printf("Incorrect.\n");
+    return 0;
+  }
+  printf("Correct.\n");
+  return 0;
+}
@@ -0,0 +1,23 @@
+// sample7.cpp: read a permutation and a strictly increasing sequence
+#include "checkerlib.h"
+using namespace checker;
+
+const int MAX_N = 100000;
+const long long MAX_A = 1000000000000000000LL;
+
+int main() {
+  Reader in(stdin);
+  const int N = in.readInt("N").range(1,MAX_N).eol();
+  PermutationChecker perm(N);
+  for(int i = 0; i < N; i++) {
+    perm.check(in.readInt("p[%d]", i)).ary(i,N);
+  }
+  perm.finish(in);
+  SortedChecker<long long> increasing(true);
+  DistinctChecker<long long> distinct(-MAX_A, MAX_A);
+  for(int i = 0; i < N; i++) {
+    distinct.check(increasing.check(in.readLong("a[%d]", i))).ary(i,N);
+  }
+  in.readEof();
+  return 0;
+}
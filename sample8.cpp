@@ -0,0 +1,16 @@
+// sample8.cpp: read a tree given as N-1 edges
+#include "checkerlib.h"
+using namespace checker;
+
+const int MAX_N = 100000;
+
+int main() {
+  Reader in(stdin);
+  const int N = in.readInt("N").range(2,MAX_N).eol();
+  std::vector<int> u, v;
+  in.readIntPairs(u, v, N-1, 1, N, "u", "v");
+  checkNoSelfLoops(u, v);
+  checkTree(N, u, v);
+  in.readEof();
+  return 0;
+}
@@ -0,0 +1,46 @@
+// sample9.cpp: reactive, judging many tests at once
+#include "checkerlib.h"
+using namespace checker;
+
+const int MAX_N = 100000;
+const int MIN_X = -1000000000;
+const int MAX_X =  1000000000;
+
+void interact(Reader& in, Process& p, int) {
+  const int N = in.readInt("N").range(1,MAX_N).spc();
+  const int K = in.readInt("K").range(1,MAX_N).eol();
+  std::vector<int> xs;
+  in.readInts(xs, N, MIN_X, MAX_X, Reader::ROW, "xs");
+  in.readEof();
+  p.writeInt(N).writeSpace().writeInt(K).writeLine();
+  p.flush();
+  for(int count = 0; ; count++) {
+    if(count == K) p.abortReadingWithError("too many queries");
+    const int guess = p.readInt("guess[%d]",count).range(0,N-1).eol();
+    p.writeInt(xs[guess]).writeLine();
+    p.flush();
+    if(xs[guess] == 0) break;
+  }
+  p.closeWriting();
+  p.readEof();
+  p.closeProcess();
+}
+
+int main(int argc, char *argv[]) {
+  if(argc < 3) {
+    fprintf(stderr, "usage: %s solution input...\n", argv[0]);
+    return 2;
+  }
+  std::vector<std::string> inputs(argv+2, argv+argc);
+  ProcessPool pool;
+  pool.push(argv[1]).setTimeLimit(2000).setReadTimeout(10000);
+  std::vector<ProcessPool::Result> results = pool.run(inputs, interact);
+  bool accepted = true;
+  for(size_t i = 0; i < results.size(); i++) {
+    const ProcessPool::Result& r = results[i];
+    printf("%s: %s %.3fs %ldKB %s\n", inputs[i].c_str(), ProcessPool::verdictName(r.verdict),
+        r.usage.user_time + r.usage.sys_time, r.usage.max_rss, r.message.c_str());
+    accepted = accepted && r.verdict == ProcessPool::ACCEPTED;
+  }
+  return accepted ? 0 : 1;
+}